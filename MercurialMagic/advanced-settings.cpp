@@ -3,24 +3,36 @@ AdvancedTab::AdvancedTab(TabFrame* parent) : TabFrameItem(parent) {
   layout.setMargin(5);
 
   sd2snesForceManifest.setText("SD2SNES/Snes9x only: Force manifest creation (for testing)").onToggle([&] {
-    program->sd2snesForceManifest = sd2snesForceManifest.checked();
-    program->basicTab.outputExtLabel.setText({".sfc", program->sd2snesForceManifest ? "/" : ""});
+    program->exporter.sd2snesForceManifest = sd2snesForceManifest.checked();
+    program->basicTab.outputExtLabel.setText({".sfc", program->exporter.sd2snesForceManifest ? "/" : ""});
   });
 
   violateBPS.setText("Violate BPS and allow multi-patching").onToggle([&] {
-    program->violateBPS = violateBPS.checked();
+    program->exporter.violateBPS = violateBPS.checked();
     program->valid = program->validateROMPatch();
     program->exportButton.setEnabled(program->valid && program->outputName());
   });
+
+  detectLoops.setText("Detect loop points in MSU-1 tracks without loop metadata").onToggle([&] {
+    program->exporter.detectLoops = detectLoops.checked();
+  });
+
+  incrementalExport.setText("Only rewrite files that changed since the previous export").onToggle([&] {
+    program->exporter.incremental = incrementalExport.checked();
+  });
 }
 
 auto AdvancedTab::refresh() -> void {
   sd2snesForceManifest.setVisible(program->icarus && program->daedalus);
-  sd2snesForceManifest.setChecked(program->sd2snesForceManifest);
-  violateBPS.setChecked(program->violateBPS);
+  sd2snesForceManifest.setChecked(program->exporter.sd2snesForceManifest);
+  violateBPS.setChecked(program->exporter.violateBPS);
+  detectLoops.setChecked(program->exporter.detectLoops);
+  incrementalExport.setChecked(program->exporter.incremental);
 }
 
 auto AdvancedTab::setEnabled(bool enabled) -> void {
   sd2snesForceManifest.setEnabled(enabled && sd2snesForceManifest.visible());
   violateBPS.setEnabled(enabled);
+  detectLoops.setEnabled(enabled);
+  incrementalExport.setEnabled(enabled);
 }
@@ -7,6 +7,7 @@ BasicTab::BasicTab(TabFrame* parent) : TabFrameItem(parent) {
     outputName.setText(Location::prefix(packPath.text().transform("\\", "/")));
     program->valid = program->validatePack();
     program->exportButton.setEnabled(program->valid && outputName.text());
+    program->verifyButton.setEnabled(program->exporter.hasROM || program->exporter.hasPatch);
   });
   packChange.setText("Change ...").onActivate([&] {
     packPath.setText(BrowserDialog()
@@ -44,26 +45,26 @@ BasicTab::BasicTab(TabFrame* parent) : TabFrameItem(parent) {
   selectLabel.setText("Export as...");
 
   gamepakExport.setText("Game Pak (cartridge folder)").onActivate([&] {
-    program->exportMethod = Program::ExportMethod::GamePak;
+    program->exporter.exportMethod = Exporter::ExportMethod::GamePak;
     gamepakCreateManifest.setEnabled(program->icarus || program->daedalus);
     outputExtLabel.setText(".sfc/");
   });
 
   gamepakCreateManifest.onToggle([&] {
-    program->createManifest = gamepakCreateManifest.checked();
+    program->exporter.createManifest = gamepakCreateManifest.checked();
   });
 
   sd2snesExport.setText("SD2SNES/Snes9x").onActivate([&] {
-    program->exportMethod = Program::ExportMethod::SD2SNES;
+    program->exporter.exportMethod = Exporter::ExportMethod::SD2SNES;
     gamepakCreateManifest.setEnabled(false);
-    outputExtLabel.setText({".sfc", program->createManifest ? "/" : ""});
+    outputExtLabel.setText({".sfc", program->exporter.createManifest ? "/" : ""});
   });
 }
 
 auto BasicTab::refresh() -> void {
   gamepakCreateManifest.setEnabled(program->icarus || program->daedalus);
-  gamepakCreateManifest.setChecked(program->createManifest).onToggle([&] {
-    program->createManifest = gamepakCreateManifest.checked();
+  gamepakCreateManifest.setChecked(program->exporter.createManifest).onToggle([&] {
+    program->exporter.createManifest = gamepakCreateManifest.checked();
   });
   if(program->icarus || program->daedalus) {
     string higanMin = program->daedalus ? "v094" : "v096";
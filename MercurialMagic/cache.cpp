@@ -0,0 +1,69 @@
+//patched ROM cache: the same patch applied to the same source ROM always yields the same ROM,
+//so each patched ROM is stored once, named after what it was derived from, and copied into
+//every destination that needs it (as a reflink where the file system supports one)
+//least recently used entries are evicted once the cache grows beyond its size limit
+
+//returns an empty string when the cache is disabled, or the source ROM cannot be read
+auto Exporter::cacheName() -> string {
+  if(!cacheDirectory || !cacheLimit) return "";
+  auto patch = fetch("patch.bps");
+  auto source = checksum(romPath);
+  if(!patch || !source) return "";
+  return {hex(source(), 8L), "-", hex(patch().crc32, 8L), violateBPS ? "-multi" : "", ".rom"};
+}
+
+auto Exporter::restoreROM(const string& name, const string& targetPath) -> bool {
+  string path = {cacheDirectory, name};
+  if(!file::exists(path)) return false;
+  if(!file::copy(path, targetPath)) return false;
+  file::touch(path);  //marks the entry as recently used
+  return true;
+}
+
+auto Exporter::storeROM(const string& name, const string& targetPath) -> void {
+  if(!directory::create(cacheDirectory)) return;
+  //entries are written under a temporary name, so that other exports never see a partial entry
+  //each export claims a name of its own: exports of the same game may store the same entry at once
+  string path = {cacheDirectory, name};
+  string partial;
+  for(uint n = 0;; n++) {
+    partial = {path, ".", n, ".part"};
+    if(file::reserve(partial)) break;
+    if(!file::exists(partial) || n == 255) return;  //the cache is not writable
+  }
+  if(!file::copy(targetPath, partial) || !file::rename(partial, path)) {
+    file::remove(partial);
+    return;
+  }
+  evictROMs();
+}
+
+auto Exporter::evictROMs() -> void {
+  struct Entry {
+    string path;
+    uint64_t size;
+    uint64_t timestamp;
+  };
+  vector<Entry> entries;
+  uint64_t total = 0;
+  for(auto& name : directory::files(cacheDirectory, "*.rom")) {
+    Entry entry;
+    entry.path = {cacheDirectory, name};
+    entry.size = file::size(entry.path);
+    entry.timestamp = file::timestamp(entry.path);
+    entries.append(entry);
+    total += entry.size;
+  }
+
+  //temporary names left by exports that crashed while storing an entry
+  for(auto& name : directory::files(cacheDirectory, "*.part")) {
+    string path = {cacheDirectory, name};
+    if(file::timestamp(path) + 60 * 60 < chrono::timestamp()) file::remove(path);
+  }
+
+  entries.sort([](const Entry& x, const Entry& y) { return x.timestamp < y.timestamp; });
+  for(auto& entry : entries) {
+    if(total <= cacheLimit) break;
+    if(file::remove(entry.path)) total -= entry.size;
+  }
+}
@@ -0,0 +1,212 @@
+#include <exporter.hpp>
+#include <csignal>
+
+#include "exporter.cpp"
+
+//headless front-end: exports (or only verifies) any number of packs on a pool of worker threads,
+//then prints one BML node per pack, in the order the packs were given
+//an interrupt (Ctrl+C) cancels every export in progress, and rolls them back; a second one
+//terminates at once
+
+struct Result {
+  string pack;
+  bool success = false;
+  bool cancelled = false;
+  string error;
+  string destination;
+  uint exported = 0;
+  uint skipped = 0;
+  uint duplicates = 0;
+  uint64_t bytesSaved = 0;
+  uint64_t timeSaved = 0;
+  string_vector corrupt;
+  uint64_t milliseconds = 0;
+};
+
+//shared by every worker's exporter
+static ramus::CancellationToken interrupted;
+
+static auto interrupt(int) -> void {
+  interrupted.cancel();
+  signal(SIGINT, SIG_DFL);
+}
+
+static auto usage() -> void {
+  print(
+    "usage: MercurialMagic-cli [options] pack.msu1...\n"
+    "  --rom <path>          source ROM, for packs that carry patch.bps\n"
+    "  --output <name>       output name (single pack only; default: the pack's name)\n"
+    "  --format <format>     gamepak (default) or sd2snes\n"
+    "  --manifest            Game Pak: create a manifest with icarus and daedalus\n"
+    "  --force-manifest      SD2SNES: create a manifest (for testing)\n"
+    "  --violate-bps         allow multi-patching: ignore the patch's source checksum\n"
+    "  --detect-loops        detect loop points in tracks without loop metadata\n"
+    "  --incremental         only rewrite files that changed since the previous export;\n"
+    "                        a cancelled one is resumed from .<name>.part/ beside the pack\n"
+    "  --cache-dir <path>    patched ROM cache location\n"
+    "  --cache-size <MiB>    patched ROM cache size limit (default: 256; 0 disables)\n"
+    "  --verify              check every file against its CRC32 without exporting anything\n"
+    "  --jobs <count>        packs exported in parallel (default: one per processor)\n"
+    "  --results <path>      write results to a file rather than to standard output\n"
+    "  --verbose             report each file on standard error\n"
+  );
+}
+
+static auto processors() -> uint {
+  #if defined(PLATFORM_WINDOWS)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return max(1u, (uint)info.dwNumberOfProcessors);
+  #else
+  return max(1l, sysconf(_SC_NPROCESSORS_ONLN));
+  #endif
+}
+
+#include <nall/main.hpp>
+auto nall::main(string_vector args) -> void {
+  args.takeLeft();  //ignore program location in argument parsing
+
+  Exporter settings;
+  string_vector packs;
+  string resultsPath;
+  uint jobs = processors();
+  bool verbose = false;
+  bool verifyOnly = false;
+
+  while(args) {
+    string argument = args.takeLeft();
+    auto value = [&]() -> string {
+      if(args) return args.takeLeft();
+      print(stderr, "error: ", argument, " requires a value\n");
+      exit(EXIT_FAILURE);
+      return "";
+    };
+
+    if(argument == "--rom") settings.romPath = value();
+    else if(argument == "--output") settings.outputName = value();
+    else if(argument == "--format") {
+      string format = value().downcase();
+      if(format == "gamepak") settings.exportMethod = Exporter::ExportMethod::GamePak;
+      else if(format == "sd2snes") settings.exportMethod = Exporter::ExportMethod::SD2SNES;
+      else return print(stderr, "error: unknown format ", format, "\n"), exit(EXIT_FAILURE);
+    }
+    else if(argument == "--manifest") settings.createManifest = true;
+    else if(argument == "--force-manifest") settings.sd2snesForceManifest = true;
+    else if(argument == "--violate-bps") settings.violateBPS = true;
+    else if(argument == "--detect-loops") settings.detectLoops = true;
+    else if(argument == "--incremental") settings.incremental = true;
+    else if(argument == "--cache-dir") {
+      settings.cacheDirectory = value();
+      if(settings.cacheDirectory && !settings.cacheDirectory.endsWith("/")) settings.cacheDirectory.append("/");
+    }
+    else if(argument == "--cache-size") settings.cacheLimit = value().natural() << 20;
+    else if(argument == "--verify") verifyOnly = true;
+    else if(argument == "--jobs") jobs = max(1u, (uint)value().natural());
+    else if(argument == "--results") resultsPath = value();
+    else if(argument == "--verbose") verbose = true;
+    else if(argument == "--help") return usage();
+    else if(argument.beginsWith("--")) return print(stderr, "error: unknown option ", argument, "\n"), exit(EXIT_FAILURE);
+    else packs.append(argument);
+  }
+
+  if(!packs) return usage(), exit(EXIT_FAILURE);
+  if(settings.outputName && packs.size() > 1) {
+    return print(stderr, "error: --output requires a single pack\n"), exit(EXIT_FAILURE);
+  }
+
+  vector<Result> results;
+  results.resize(packs.size());
+  std::atomic<uint> next{0};
+  std::mutex console;
+  signal(SIGINT, interrupt);
+
+  auto worker = [&](uintptr_t) -> void {
+    while(true) {
+      uint index = next++;
+      if(index >= packs.size()) break;
+      auto& result = results[index];
+      result.pack = packs[index];
+      if(interrupted) {
+        result.cancelled = true;
+        result.error = "Cancelled.";
+        continue;
+      }
+      auto start = chrono::millisecond();
+
+      Exporter exporter;
+      exporter.romPath = settings.romPath;
+      exporter.outputName = settings.outputName ? settings.outputName : Location::prefix(result.pack);
+      exporter.exportMethod = settings.exportMethod;
+      exporter.createManifest = settings.createManifest;
+      exporter.sd2snesForceManifest = settings.sd2snesForceManifest;
+      exporter.violateBPS = settings.violateBPS;
+      exporter.detectLoops = settings.detectLoops;
+      exporter.incremental = settings.incremental;
+      exporter.cacheDirectory = settings.cacheDirectory;
+      exporter.cacheLimit = settings.cacheLimit;
+      exporter.cancellation = interrupted;
+      if(verbose) exporter.onInformation = [&](const string& text) {
+        std::lock_guard<std::mutex> lock(console);
+        print(stderr, Location::file(result.pack), ": ", text, "\n");
+      };
+
+      if(!exporter.open(result.pack)) {
+        result.error = "Not a valid MSU1 pack.";
+      } else if(verifyOnly) {
+        result.success = exporter.verify();
+        if(!result.success) result.error = "Corrupt files in the MSU1 pack (CRC32 mismatch).";
+      } else if(exporter.hasPatch && !exporter.validateROM()) {
+        result.error = exporter.error ? exporter.error : string{"A source ROM is required (--rom)."};
+      } else if(!exporter.run()) {
+        result.error = exporter.error;
+        if(exporter.errorLink) result.error.append(" (see ", exporter.errorLink, ")");
+      } else {
+        result.success = true;
+      }
+      if(!result.success && interrupted) {
+        result.cancelled = true;
+        result.error = "Cancelled.";
+      }
+      exporter.close();
+
+      result.destination = exporter.destination;
+      result.exported = exporter.exported;
+      result.skipped = exporter.skipped;
+      result.duplicates = exporter.duplicates;
+      result.bytesSaved = exporter.bytesSaved;
+      result.timeSaved = exporter.timeSaved / 1000;
+      result.corrupt = exporter.corrupt;
+      result.milliseconds = chrono::millisecond() - start;
+    }
+  };
+
+  vector<thread> workers;
+  while(workers.size() < min(jobs, packs.size())) workers.append(thread::create(worker));
+  for(auto& worker : workers) worker.join();
+
+  Markup::Node document;
+  uint failures = 0;
+  for(auto& result : results) {
+    Markup::Node node{"pack", result.pack};
+    node("status").setValue(result.success ? (verifyOnly ? "verified" : "exported") : result.cancelled ? "cancelled" : "failed");
+    if(result.error) node("error").setValue(string{result.error}.replace("\n", " "));
+    for(auto& name : result.corrupt) node.append(Markup::Node{"corrupt", name});
+    if(result.destination) node("destination").setValue(result.destination);
+    if(!verifyOnly) {
+      node("exported").setValue(result.exported);
+      node("skipped").setValue(result.skipped);
+    }
+    if(result.duplicates) {
+      node("duplicates").setValue(result.duplicates);
+      node("duplicates/bytes-saved").setValue(result.bytesSaved);
+      node("duplicates/milliseconds-saved").setValue(result.timeSaved);
+    }
+    node("milliseconds").setValue(result.milliseconds);
+    document.append(node);
+    if(!result.success) failures++;
+  }
+
+  if(resultsPath) file::write(resultsPath, BML::serialize(document));
+  else print(BML::serialize(document));
+  exit(failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
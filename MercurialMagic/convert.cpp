@@ -1,40 +1,144 @@
 #include <ramus/decode/wave.hpp>
+#include <ramus/decode/mp3.hpp>
+#include <ramus/decode/loop-point.hpp>
+#include <ramus/dsp/loop-finder.hpp>
+#include <nall/dsp/resampler/cubic.hpp>
+
+//audio tracks are streamed from the archive to their final .pcm without intermediate files
+//pipeline stages: inflate (inflateTracks thread) -> decode (writePCM thread) -> resample and write (export thread)
+//on cancellation, the inflate and decode stages stop producing, and the stages after them drain and stop
+
+auto Exporter::isTrack(string_view name) -> bool {
+  string ext = Location::suffix(name);
+  return ext == ".wav" || ext == ".ogg" || ext == ".flac" || ext == ".mp3";
+}
+
+//inflate stage: decompresses tracks ahead of the export thread, in archive order
+//stored entries are passed through as views of the archive mapping, after being checked against
+//their CRC32 here, which also brings them into memory ahead of the decoder
+//unchanged tracks, and duplicates of earlier tracks, are skipped
+auto Exporter::inflateTracks() -> void {
+  for(uint index : range(pack.file.size())) {
+    if(cancellation) break;
+    auto& file = pack.file[index];
+    if(!isTrack(file.name) || unchanged[index] || original[index] != index) continue;
+    Track track;
+    if(file.cmode == 0) {
+      track.data = pack.contents(file);
+      track.size = file.size;
+      track.corrupt = !track.data || Hash::CRC32(track.data, track.size).value() != file.crc32;
+    } else if(file.size <= ~0u) {
+      track.buffer.resize(file.size);
+      track.corrupt = !pack.extract(file, track.buffer.data());
+    } else {
+      track.corrupt = true;
+    }
+    if(!tracks->push(move(track))) break;
+  }
+  tracks->close();
+}
+
+//path is where the track would be exported; its .pcm conversion is written beside it
+//sets unwritable
+auto Exporter::convert(const string& path, const Track& track, bool& unwritable) -> bool {
+  unwritable = false;
+  string pcmPath = {Location::path(path), Location::prefix(path), ".pcm"};
+  const uint8_t* data = track.buffer ? track.buffer.data() : track.data;
+  uint size = track.buffer ? track.buffer.size() : track.size;
+  if(!data) return false;
 
-auto Program::convert(string path) -> bool {
   if(Location::suffix(path) == ".wav") {
-    /*
-    auto data = file::read(path);
-    ramus::Decode::Wave audio(data);
+    ramus::Decode::Wave audio(data, size);
+    auto loop = ramus::Decode::loopPoint(data, size);
+    if(audio) {
+      if(!writePCM(pcmPath, audio, loop, unwritable)) return false;
+    } else {
+      //formats the native decoder does not handle (e.g. A-law, mu-law)
+      file::write(path, data, size);
+      execute("wav2msu", path, "-l", string{loop ? loop() : 0});
+      file::remove(path);
+    }
+  }
+
+  if(Location::suffix(path) == ".mp3") {
+    ramus::Decode::MP3 audio(data, size);
     if(!audio) return false;
 
-    if(audio.frequency != 44100) return false;
+    if(!writePCM(pcmPath, audio, ramus::Decode::loopPoint(data, size), unwritable)) return false;
+  }
+
+  return file::exists(pcmPath);
+}
+
+//writes an MSU1 PCM track (44.1KHz 16-bit stereo), resampling from the decoder's native frequency
+//loop is in source samples; untagged tracks are searched for a loop point when enabled
+//sets unwritable when the .pcm could not be written in full (e.g. the disk is full)
+template<typename Decoder> auto Exporter::writePCM(const string& path, Decoder& audio, maybe<uint> loop, bool& unwritable) -> bool {
+  file fp;
+  if(!fp.open(path, file::mode::write)) return unwritable = true, false;
+  fp.writes("MSU1");
+  fp.writel(loop ? (uint)((uint64_t)loop() * 44100 / audio.frequency) : 0, 4);
 
-    uint loop = 0;
+  ramus::DSP::LoopFinder finder;
+  bool detect = !loop && detectLoops;
+  if(detect) finder.reset(44100);
 
-    file fp;
-    if(fp.open({Location::path(path), Location::prefix(path), ".pcm"}, file::mode::write)) {
-      fp.writes("MSU1");
-      fp.writel(loop, 4);
-      while(audio) {
-        auto sample = audio.sample();
-        fp.writel(sample[0] * 32768.0, 2);
-        fp.writel(sample[1] * 32768.0, 2);
+  //decode stage: runs ahead of resampling and writing, bounded by the sample ring
+  ramus::RingBuffer<double> samples{1 << 16};
+  uint frequency = audio.frequency;
+  auto decoder = thread::create([&](uintptr) {
+    double block[1024];
+    uint count = 0;
+    while(audio && !cancellation) {
+      auto sample = audio.sample();
+      block[count++] = sample[0];
+      block[count++] = sample[1];
+      if(count == 1024) {
+        if(!samples.push(block, count)) return;
+        count = 0;
       }
-      fp.close();
-    } else {
-      error({Location::path(path), Location::prefix(path), ".pcm"});
-      return false;
     }
-    */
+    samples.push(block, count);
+    samples.close();
+  });
 
-    uint loop = 0;
-    execute("wav2msu", path, "-l", string{loop});
-  }
+  uint8_t buffer[4096];
+  uint size = 0;
+  auto output = [&](double left, double right) {
+    for(double sample : {left, right}) {
+      int16_t value = sclamp<16>(round(sample * 32768.0));
+      buffer[size++] = value >> 0;
+      buffer[size++] = value >> 8;
+    }
+    if(size == sizeof(buffer)) fp.write(buffer, size), size = 0;
+    if(detect) finder.write(left, right);
+  };
 
-  if(file::exists({Location::path(path), Location::prefix(path), ".pcm"})) {
-    file::remove(path);
-    return true;
+  double block[1024];
+  if(frequency == 44100) {
+    while(uint count = samples.pop(block, 1024)) {
+      for(uint n = 0; n < count; n += 2) output(block[n], block[n + 1]);
+    }
   } else {
-    return false;
+    DSP::Resampler::Cubic resampler[2];
+    for(auto& channel : resampler) channel.reset(frequency, 44100);
+    while(uint count = samples.pop(block, 1024)) {
+      for(uint n = 0; n < count; n += 2) {
+        resampler[0].write(block[n]);
+        resampler[1].write(block[n + 1]);
+        while(resampler[0].pending()) output(resampler[0].read(), resampler[1].read());
+      }
+    }
+  }
+  decoder.join();
+
+  if(size) fp.write(buffer, size);
+  if(detect) {
+    if(auto found = finder.find()) {
+      fp.seek(4);
+      fp.writel(found(), 4);
+    }
   }
+  if(!fp.close()) return unwritable = true, false;
+  return true;
 }
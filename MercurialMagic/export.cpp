@@ -1,27 +1,49 @@
 #include <ramus/patch/bps-ignore-size.hpp>
 
-auto Program::beginExport() -> void {
+auto Exporter::beginExport() -> bool {
   setDestination();
-  directory::create(destination);
+  if(!beginStaging()) return failure("Could not create the staging folder beside the pack.");
 
   zipIndex = 0;
-  setProgress(0);
+  trackIDs.reset();
+  bytesDone = 0;
+  bytesTotal = 0;
+  for(auto& file : pack.file) bytesTotal += file.size;
+  progress(0);
+
+  loadExportState();
+  unchanged.reset();
+  for(auto& file : pack.file) {
+    string path = exportPath(file.name);
+    unchanged.append(path && isUnchanged(outputPath(file.name, path), signature(file)));
+  }
+  findDuplicates();
 
-  bpspatch* patch = nullptr;
-  ramus::bpspatch_ignore_size* patch_ignore_size = nullptr;
+  unique_pointer<bpspatch> patch;
+  unique_pointer<ramus::bpspatch_ignore_size> patch_ignore_size;
   if(patchContents) {
     if(!violateBPS) {
       patch = new bpspatch;
       patch->modify(patchContents.data(), patchContents.size());
-      patch->source(romPath());
+      patch->source(romPath);
+      if(auto checksum = this->checksum(romPath)) patch->setSourceChecksum(checksum());
     } else {
       patch_ignore_size = new ramus::bpspatch_ignore_size;
       patch_ignore_size->modify(patchContents.data(), patchContents.size());
-      patch_ignore_size->source(romPath());
+      patch_ignore_size->source(romPath);
     }
   }
 
   string targetPath;
+  string targetSignature;
+  static string_vector roms = {
+    "program.rom",
+    "data.rom",
+    "slot-*.rom",
+    "*.boot.rom",
+    "*.program.rom",
+    "*.data.rom",
+  };
 
   switch(exportMethod) {
 
@@ -32,57 +54,66 @@ auto Program::beginExport() -> void {
   }
 
   case ExportMethod::SD2SNES: {
-    string filename = sd2snesForceManifest ? "program.rom" : string{outputName(), ".sfc"};
-    static string_vector roms = {
-      "program.rom",
-      "data.rom",
-      "slot-*.rom",
-      "*.boot.rom",
-      "*.program.rom",
-      "*.data.rom",
-    };
-
-    file rom({destination, filename}, file::mode::write);
+    targetPath = {destination, sd2snesForceManifest ? "program.rom" : string{outputName, ".sfc"}};
     for(string& romName : roms) {
-      if(auto file = fetch(romName)) {
-        rom.write(pack.extract(file()).data(), file().size);
-      }
+      if(auto file = fetch(romName)) targetSignature.append(signature(file()), ";");
     }
-    rom.close();
-
-    targetPath = {destination, filename};
 
     break;
   }
 
   }
 
+  //the patched ROM depends on the patch and, when the patch's source checksum is ignored, on the ROM itself
+  if(patchContents) {
+    if(auto file = fetch("patch.bps")) targetSignature.append("patch=", signature(file()));
+    if(violateBPS) targetSignature.append(";source=", file::size(romPath), ":", file::timestamp(romPath));
+  }
+
+  bool targetUnchanged = targetSignature && isUnchanged(targetPath, targetSignature);
+  saveExportState();
+  if(!targetUnchanged && (exportMethod == ExportMethod::SD2SNES || patchContents)) stage(targetPath);
+
+  if(targetUnchanged) {
+    patch.reset();
+    patch_ignore_size.reset();
+  } else if(exportMethod == ExportMethod::SD2SNES && !patch && !patch_ignore_size) {
+    //a patch writes the whole target from the source ROM, so the components are only assembled without one
+    if(!buildROM(targetPath, roms)) {
+      if(!corrupt) return failure("Could not build the ROM: its file could not be written.");
+      return failure({"Could not build the ROM: ", corrupt.merge(", "), " is corrupt in the MSU1 pack (CRC32 mismatch)."});
+    }
+  }
+
+  string cacheEntry = patch || patch_ignore_size ? cacheName() : "";
+  if(cacheEntry && restoreROM(cacheEntry, targetPath)) {
+    patch.reset();
+    patch_ignore_size.reset();
+  }
+  if(cancellation) return false;
+
   if(patch) {
     patch->target(targetPath);
     uint patchResult = patch->apply();
     switch(patchResult) {
     case bpspatch::result::unknown:
-      return error("There was an unspecified problem in applying the BPS patch.");
+      return failure("There was an unspecified problem in applying the BPS patch.");
     case bpspatch::result::patch_invalid_header:
-      return error("The BPS patch's header is invalid!");
+      return failure("The BPS patch's header is invalid!");
     case bpspatch::result::target_too_small:
     case bpspatch::result::target_checksum_invalid:
     case bpspatch::result::patch_too_small:
     case bpspatch::result::patch_checksum_invalid:
-      return error("The BPS patch is corrupt!");
+      return failure("The BPS patch is corrupt!");
     case bpspatch::result::source_too_small:
-      return error({
+      return failure({
         "This ROM is too small!\n",
         "Check that you are selecting the correct ROM, and try again."
       });
     case bpspatch::result::source_checksum_invalid:
-      uint32_t expectedCRC32 = 0;
-      for(uint i : range(4)) {
-        expectedCRC32 |= patchContents[patchContents.size() - 12 + i] << (i << 3);
-      }
-      return error({
+      return failure({
         "The patch is not compatible with this ROM.\n",
-        "Expected CRC32: ", hex(expectedCRC32, 8L).upcase()
+        "Expected CRC32: ", hex(expectedChecksum(), 8L).upcase()
       });
     }
   } else if(patch_ignore_size) {
@@ -90,146 +121,127 @@ auto Program::beginExport() -> void {
     uint patchResult = patch_ignore_size->apply();
     switch(patchResult) {
     case ramus::bpspatch_ignore_size::result::unknown:
-      return error("There was an unspecified problem in applying the BPS patch.");
+      return failure("There was an unspecified problem in applying the BPS patch.");
     case ramus::bpspatch_ignore_size::result::patch_invalid_header:
-      return error("The BPS patch's header is invalid!");
+      return failure("The BPS patch's header is invalid!");
     case ramus::bpspatch_ignore_size::result::target_too_small:
     case ramus::bpspatch_ignore_size::result::patch_too_small:
     case ramus::bpspatch_ignore_size::result::patch_checksum_invalid:
-      return error("The BPS patch is corrupt!");
+      return failure("The BPS patch is corrupt!");
     case ramus::bpspatch_ignore_size::result::source_too_small:
-      return error({
+      return failure({
         "This ROM is too small!\n",
         "Check that you are selecting the correct ROM, and try again."
       });
     }
   }
 
-  if(patch) delete patch;
-  if(patch_ignore_size) delete patch_ignore_size;
-
-  thread::create([&](uintptr_t) -> void {
-    while(zipIndex < pack.file.size()) {
-      if(!iterateExport()) break;
-    }
-    finishExport();
-  });
+  bool patched = patch || patch_ignore_size;
+  patch.reset();
+  patch_ignore_size.reset();
+  if(cacheEntry && patched) storeROM(cacheEntry, targetPath);
+  if(targetSignature) exportRecord(targetPath, targetSignature);
+  return true;
 }
 
-auto Program::iterateExport() -> bool {
+auto Exporter::iterateExport() -> bool {
+  if(cancellation) return false;
   auto& file = pack.file[zipIndex++];
-  information({"Exporting ", file.name, "..."});
-
-  string ext = Location::suffix(file.name);
-  string path;
-  uint16_t trackID;
-  if(ext == ".pcm"
-  || ext == ".wav"
-  || ext == ".ogg"
-  || ext == ".flac"
-  || ext == ".mp3") {
-    uint start = 0;
-    uint length = 0;
-    for(uint pos : range(0, file.name.size())) {
-      if(file.name[pos] >= '0' && file.name[pos] <= '9') { start = pos; break; }
-    }
-    for(uint pos : range(start, file.name.size())) {
-      if(file.name[pos] < '0' || file.name[pos] > '9') { length = pos - start; break; }
-    }
-    trackID = slice(file.name, start, length).natural();
-    trackIDs.append(trackID);
+  string name = file.name;
+  string ext = Location::suffix(name);
+  string path = exportPath(name);
+  if(ext == ".pcm" || isTrack(name)) trackIDs.append(trackID(name));
+
+  uint index = zipIndex - 1;
+  if(unchanged[index]) {
+    information({"Skipping unchanged ", name, "..."});
+    bytesDone += file.size;
+    progress(zipIndex);
+    skipped++;
+    return true;
   }
+  information({"Exporting ", name, "..."});
+  if(path) stage(outputPath(name, path));
 
-  switch(exportMethod) {
-
-  case ExportMethod::GamePak: {
-    if(ext == ".pcm"
-    || ext == ".wav"
-    || ext == ".ogg"
-    || ext == ".flac"
-    || ext == ".mp3") {
-      path = {destination, "track-", trackID, ext};
-    } else if(ext != ".bps") {
-      path = {destination, file.name};
+  bool result = true;
+  bool damaged = false;
+  bool unwritable = false;
+  auto start = chrono::microsecond();
+  if(original[index] != index) {
+    //the first entry with this content has already been exported: its output is copied
+    auto& first = pack.file[original[index]];
+    string output = outputPath(name, path);
+    result = file::copy(outputPath(first.name, exportPath(first.name)), output);
+    if(result) {
+      duplicates++;
+      bytesSaved += file::size(output);
+      uint64_t copied = chrono::microsecond() - start;
+      if(elapsed[original[index]] > copied) timeSaved += elapsed[original[index]] - copied;
     }
-    break;
+  } else if(isTrack(name)) {
+    Track track;
+    result = tracks->pop(track);
+    if(result && track.corrupt) result = false, damaged = true;
+    else if(result) result = convert(path, track, unwritable);
+  } else if(path) {
+    result = writeEntry(path, file, damaged);
+    unwritable = !result && !damaged;
   }
+  elapsed[index] = chrono::microsecond() - start;
+  if(cancellation) return false;  //the output may be incomplete
 
-  case ExportMethod::SD2SNES: {
-    string ext = Location::suffix(file.name);
-    if(ext == ".pcm"
-    || ext == ".wav"
-    || ext == ".ogg"
-    || ext == ".flac"
-    || ext == ".mp3") {
-      path = {destination, outputName(), "-", trackID, ext};
-    } else if(file.name == "msu1.rom") {
-      path = {destination, sd2snesForceManifest ? "msu1.rom" : string{outputName(), ".msu"}};
-    } else if(file.name.endsWith("program.rom")) {
-      path = "";
-    } else if(file.name.endsWith("data.rom")) {
-      path = "";
-    }
+  if(result && path) exportRecord(outputPath(name, path), signature(file));
 
-    break;
+  if(damaged) {
+    corrupt.append(name);
+    return failure({name, " is corrupt in the MSU1 pack (CRC32 mismatch)."});
   }
 
+  if(unwritable) {
+    return failure({
+      "Could not write ", name, "!\n"
+      "Please check that the destination is writable, and has enough free space."
+    });
   }
 
-  if(path) file::write(path, pack.extract(file));
-
-  bool result = true;
-  if(ext == ".wav"
-  || ext == ".ogg"
-  || ext == ".flac"
-  || ext == ".mp3") result = convert(path);
-
   if(!result) {
     if(ext == ".wav") {
-      string response = error({
-        "Could not convert ", file.name, " to PCM!\n"
-        "Please check if wav2msu is installed correctly.\n"
-        #if defined(PLATFORM_WINDOWS)
-        "Would you like to download wav2msu from SMW Central?"
-        #else
-        "Would you like to visit wav2msu's GitHub page?"
-        #endif
-      }, {"Yes", "No"});
-      if(response == "Yes") {
-        #if defined(PLATFORM_WINDOWS)
-        invoke("https://www.smwcentral.net/?p=section&a=details&id=4872");
-        #else
-        invoke("https://github.com/jbaiter/wav2msu");
-        #endif
-      }
-      thread::exit();
+      return failure({
+        "Could not convert ", name, " to PCM!\n"
+        "Please check if wav2msu is installed correctly."
+      },
+      #if defined(PLATFORM_WINDOWS)
+      "https://www.smwcentral.net/?p=section&a=details&id=4872"
+      #else
+      "https://github.com/jbaiter/wav2msu"
+      #endif
+      );
     } else if(ext == ".ogg") {
-      error({
-        "Could not convert ", file.name, " to PCM!\n"
+      return failure({
+        "Could not convert ", name, " to PCM!\n"
         "Ogg Vorbis is not currently supported."
       });
-      thread::exit();
     } else if(ext == ".flac") {
-      error({
-        "Could not convert ", file.name, " to PCM!\n"
+      return failure({
+        "Could not convert ", name, " to PCM!\n"
         "FLAC is not currently supported."
       });
-      thread::exit();
     } else if(ext == ".mp3") {
-      error({
-        "Could not convert ", file.name, " to PCM!\n"
-        "MP3 is not currently supported."
+      return failure({
+        "Could not convert ", name, " to PCM!\n"
+        "The MP3 file could not be decoded."
       });
-      thread::exit();
     }
-    return false;
+    return failure({"Could not export ", name, "!"});
   }
 
-  setProgress(zipIndex);
+  bytesDone += file.size;
+  progress(zipIndex);
+  if(path) exported++;
   return true;
 }
 
-auto Program::finishExport() -> void {
+auto Exporter::finishExport() -> void {
   string icarusManifest;
   string daedalusManifest;
 
@@ -246,6 +258,7 @@ auto Program::finishExport() -> void {
           daedalusManifest = {daedalusManifest.split("\n\n").left(), "\n\n"};
         }
       }
+      file::remove({destination, "manifest.bml"});
       file::write({destination, "manifest.bml"}, {daedalusManifest, icarusManifest});
     }
     break;
@@ -253,6 +266,10 @@ auto Program::finishExport() -> void {
 
   case ExportMethod::SD2SNES: {
     if(sd2snesForceManifest) {
+      //outputs an incremental export kept are still under their final names: the manifest is
+      //generated from the usual ones
+      if(!file::exists({destination, "program.rom"})) file::rename({destination, outputName, ".sfc"}, {destination, "program.rom"});
+      if(!file::exists({destination, "msu1.rom"})) file::rename({destination, outputName, ".msu"}, {destination, "msu1.rom"});
       if(auto manifest = execute("icarus", "--manifest", destination)) {
         icarusManifest = manifest.output;
       }
@@ -263,11 +280,11 @@ auto Program::finishExport() -> void {
         }
       }
 
-      static auto substitute = [&](string& manifest) -> void {
+      auto substitute = [&](string& manifest) -> void {
         manifest.
-          replace("program.rom", {"\"", outputName(), ".sfc\""}).
-          replace("save.ram",    {"\"", outputName(), ".srm\""}).
-          replace("msu1.rom",    {"\"", outputName(), ".msu\""});
+          replace("program.rom", {"\"", outputName, ".sfc\""}).
+          replace("save.ram",    {"\"", outputName, ".srm\""}).
+          replace("msu1.rom",    {"\"", outputName, ".msu\""});
       };
       substitute(icarusManifest);
       substitute(daedalusManifest);
@@ -275,7 +292,7 @@ auto Program::finishExport() -> void {
       string tracks = "";
       trackIDs.sort();
       for(uint trackID : trackIDs) {
-        tracks.append("\n    track number=", trackID, " name=\"", outputName(), "-", trackID, ".pcm\"");
+        tracks.append("\n    track number=", trackID, " name=\"", outputName, "-", trackID, ".pcm\"");
       }
 
       string_vector sections;
@@ -286,15 +303,209 @@ auto Program::finishExport() -> void {
       sections[0].append(tracks);
       icarusManifest = sections.merge("\n\n");
 
+      file::remove({destination, "manifest.bml"});
       file::write({destination, "manifest.bml"}, {daedalusManifest, icarusManifest});
-      file::rename({destination, "program.rom"}, {destination, outputName(), ".sfc"});
-      file::rename({destination, "msu1.rom"}, {destination, outputName(), ".msu"});
+      file::rename({destination, "program.rom"}, {destination, outputName, ".sfc"});
+      file::rename({destination, "msu1.rom"}, {destination, outputName, ".msu"});
+    }
+    break;
+  }
+
+  }
+
+  saveExportState();
+}
+
+//stored entries are written straight from the archive mapping, whatever their size, and hashed
+//chunk by chunk as they are written; deflated entries are checked as they are inflated
+//returns false if the output could not be written, or if the entry does not match its CRC32, which
+//sets damaged
+auto Exporter::writeEntry(const string& path, Decode::ZIP::File& entry, bool& damaged) -> bool {
+  damaged = false;
+  if(entry.cmode != 0) {
+    if(entry.size > ~0u) return damaged = true, false;
+    vector<uint8_t> buffer;
+    buffer.resize(entry.size);
+    if(!pack.extract(entry, buffer.data())) return damaged = true, false;
+    return file::write(path, buffer);
+  }
+
+  const uint8_t* data = pack.contents(entry);
+  if(!data) return damaged = true, false;
+  file fp;
+  if(!fp.open(path, file::mode::write)) return false;
+  fp.reserve(entry.size);
+  Hash::CRC32 checksum;
+  for(uint64_t offset = 0; offset < entry.size && !cancellation; offset += 1 << 20) {
+    uint length = min<uint64_t>(1 << 20, entry.size - offset);
+    checksum.input(data + offset, length);
+    fp.write(data + offset, length);
+  }
+  damaged = checksum.value() != entry.crc32;
+  return fp.close() && !damaged;
+}
+
+//assembles the pack's ROM components into one preallocated, mapped target in a single pass
+//each component is copied or inflated straight into place, and checked against its archive CRC32
+//as it is produced, rather than being extracted into an intermediate buffer first
+auto Exporter::buildROM(const string& path, const string_vector& patterns) -> bool {
+  vector<Decode::ZIP::File> components;
+  uint64_t size = 0;
+  for(auto& pattern : patterns) {
+    if(auto file = fetch(pattern)) {
+      components.append(file());
+      size += file().size;
+    }
+  }
+
+  file fp;
+  if(!fp.open(path, file::mode::write)) return false;
+  fp.reserve(size);  //rather than sparse, so that running out of space is not a fault while mapped
+  fp.truncate(size);
+  fp.close();
+  if(!size) return true;
+
+  filemap target;
+  if(!target.open(path, filemap::mode::readwrite)) return false;
+  uint8_t* data = target.data();
+  for(auto& component : components) {
+    if(cancellation) return false;
+    if(!pack.extract(component, data)) {
+      corrupt.append(component.name);
+      return false;
     }
+    data += component.size;
+  }
+  return true;
+}
+
+//packs often repeat the same audio under several track numbers (loops, jingles, silence)
+//entries with the same CRC32, sizes and compression produce the same output, so only the first
+//of them is decoded; original[] maps every entry to the first entry with identical content
+auto Exporter::findDuplicates() -> void {
+  map<string, uint> contents;
+  original.reset();
+  elapsed.reset();
+  for(uint index : range(pack.file.size())) {
+    auto& file = pack.file[index];
+    original.append(index);
+    elapsed.append(0);
+    if(!file.size || !exportPath(file.name)) continue;
+    //the extension is part of the key, since it decides how the content is converted
+    string key = {hex(file.crc32, 8L), ":", file.size, ":", file.cmode, ":", file.csize, ":", Location::suffix(file.name)};
+    if(auto first = contents.find(key)) original[index] = first();
+    else contents.insert(key, index);
+  }
+}
+
+//returns the number in a track's file name (e.g. "track-12.wav" -> 12)
+auto Exporter::trackID(const string& name) -> uint16_t {
+  uint start = 0;
+  uint length = 0;
+  for(uint pos : range(0, name.size())) {
+    if(name[pos] >= '0' && name[pos] <= '9') { start = pos; break; }
+  }
+  for(uint pos : range(start, name.size())) {
+    if(name[pos] < '0' || name[pos] > '9') { length = pos - start; break; }
+  }
+  return slice(name, start, length).natural();
+}
+
+//returns where an archive entry is exported to, or an empty string if it is not written directly
+auto Exporter::exportPath(const string& name) -> string {
+  string ext = Location::suffix(name);
+  bool track = ext == ".pcm" || isTrack(name);
+
+  switch(exportMethod) {
+
+  case ExportMethod::GamePak: {
+    if(track) return {destination, "track-", trackID(name), ext};
+    if(ext != ".bps") return {destination, name};
     break;
   }
 
+  case ExportMethod::SD2SNES: {
+    if(track) return {destination, outputName, "-", trackID(name), ext};
+    if(name == "msu1.rom") return {destination, sd2snesForceManifest ? "msu1.rom" : string{outputName, ".msu"}};
+    break;
   }
 
-  information("MSU1 pack exported!");
-  reset();
+  }
+
+  return "";
+}
+
+//the file that is finally written for an entry: tracks are converted to .pcm beside their export path
+auto Exporter::outputPath(const string& name, const string& path) -> string {
+  if(!isTrack(name)) return path;
+  return {Location::path(path), Location::prefix(path), ".pcm"};
+}
+
+//identifies the inputs an output is generated from
+auto Exporter::signature(const Decode::ZIP::File& file) -> string {
+  string result = {hex(file.crc32, 8L), ":", file.size};
+  if(isTrack(file.name) && detectLoops) result.append(":loops");
+  return result;
+}
+
+//incremental export: each output is recorded in a state file in the destination folder,
+//along with the signature of its inputs and its size when written
+//an output is only skipped if both still match, so edited or truncated files are rewritten
+
+auto Exporter::loadExportState() -> void {
+  exportState.reset();
+  if(!incremental) return;
+  auto document = BML::unserialize(file::read({destination, ".mercurial-magic.bml"}));
+  for(auto node : document.find("output")) {
+    ExportRecord record;
+    record.signature = node["signature"].text();
+    record.size = node["size"].natural();
+    exportState.insert(node.text(), record);
+  }
+}
+
+auto Exporter::saveExportState() -> void {
+  if(!incremental) return;
+  Markup::Node document;
+  for(auto& output : exportState) {
+    Markup::Node node{"output", output.key};
+    node("signature").setValue(output.value.signature);
+    node("size").setValue(output.value.size);
+    document.append(node);
+  }
+  file::remove({destination, ".mercurial-magic.bml"});  //it may be linked to the destination's
+  file::write({destination, ".mercurial-magic.bml"}, BML::serialize(document));
+}
+
+//outputs are recorded under the names finishExport() leaves them with
+auto Exporter::recordName(const string& path) -> string {
+  string name = string{path}.trimLeft(destination, 1L);
+  if(exportMethod == ExportMethod::SD2SNES && sd2snesForceManifest) {
+    if(name == "program.rom") return {outputName, ".sfc"};
+    if(name == "msu1.rom") return {outputName, ".msu"};
+  }
+  return name;
+}
+
+auto Exporter::isUnchanged(const string& path, const string& signature) -> bool {
+  if(!incremental) return false;
+  string name = recordName(path);
+  string output = {destination, name};
+  if(auto record = exportState.find(name)) {
+    if(record().signature == signature && file::exists(output) && file::size(output) == record().size) return true;
+    //the output is about to be rewritten: beginExport() saves the state without this record
+    //before writing anything, so that an interrupted export cannot leave a stale record behind
+    exportState.remove(name);
+  }
+  return false;
+}
+
+auto Exporter::exportRecord(const string& path, const string& signature) -> void {
+  if(!incremental) return;
+  ExportRecord record;
+  record.signature = signature;
+  record.size = file::size(path);
+  string name = recordName(path);
+  exportState.remove(name);
+  exportState.insert(name, record);
 }
@@ -0,0 +1,201 @@
+#include "export.cpp"
+#include "convert.cpp"
+#include "cache.cpp"
+#include "staging.cpp"
+
+//returns false if the file is not an MSU1 pack: it needs a data track, and either a ROM or a patch
+auto Exporter::open(const string& packPath) -> bool {
+  close();
+  this->packPath = packPath;
+  if(!packPath || !file::exists(packPath)) return false;
+
+  pack.open(packPath);
+
+  if(!fetch("msu1.rom")) return false;
+  hasROM = !!fetch("program.rom");
+  if(auto file = fetch("patch.bps")) {
+    patchContents = pack.extract(file());
+    hasPatch = true;
+  }
+  return hasROM || hasPatch;
+}
+
+auto Exporter::close() -> void {
+  pack.close();
+  pack = {};
+  patchContents.reset();
+  hasROM = false;
+  hasPatch = false;
+}
+
+auto Exporter::validateROM() -> bool {
+  error = "";
+  if(!romPath || !file::exists(romPath)) return false;
+
+  if(hasPatch && !violateBPS) {
+    auto sourceChecksum = checksum(romPath);
+    if(!sourceChecksum || sourceChecksum() != expectedChecksum()) {
+      return failure({
+        "The patch is not compatible with this ROM.\n",
+        "Expected CRC32: ", hex(expectedChecksum(), 8L).upcase()
+      });
+    }
+  }
+
+  return true;
+}
+
+//the source ROM checksum recorded in the patch footer
+auto Exporter::expectedChecksum() const -> uint32_t {
+  if(patchContents.size() < 12) return 0;
+  uint32_t expectedChecksum = 0;
+  for(uint i : range(4)) {
+    expectedChecksum |= patchContents[patchContents.size() - 12 + i] << (i << 3);
+  }
+  return expectedChecksum;
+}
+
+//CRC32 of a whole file, cached by path, size and modification time
+//the cache is shared by every exporter in the process, since packs often share one source ROM
+auto Exporter::checksum(const string& path) -> maybe<uint32_t> {
+  struct Checksum {
+    uint64_t size = 0;
+    uint64_t timestamp = 0;
+    uint32_t crc32 = 0;
+  };
+  static map<string, Checksum> checksums;
+  static std::mutex mutex;
+
+  uint64_t size = file::size(path);
+  uint64_t timestamp = file::timestamp(path);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(auto cached = checksums.find(path)) {
+      if(cached().size == size && cached().timestamp == timestamp) return cached().crc32;
+      checksums.remove(path);
+    }
+  }
+
+  filemap fp;
+  if(!fp.open(path, filemap::mode::read)) return nothing;
+  Checksum entry;
+  entry.size = size;
+  entry.timestamp = timestamp;
+  entry.crc32 = Hash::CRC32(fp.data(), fp.size()).value();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  checksums.remove(path);
+  checksums.insert(path, entry);
+  return entry.crc32;
+}
+
+auto Exporter::fetch(string_view name) -> maybe<Decode::ZIP::File> {
+  for(auto& file : pack.match(name)) return file;
+  return nothing;
+}
+
+//exports the open pack on the calling thread; returns false with error set on failure
+auto Exporter::run() -> bool {
+  error = "";
+  errorLink = "";
+  exported = 0;
+  skipped = 0;
+  duplicates = 0;
+  bytesSaved = 0;
+  timeSaved = 0;
+  corrupt.reset();
+
+  written.reset();
+  destinationPath = "";
+  stagingRoot = "";
+  stagingPath = "";
+
+  bool result = beginExport();
+  if(result) {
+    tracks = new ramus::RingBuffer<Track>{2};
+    inflater = thread::create([&](uintptr_t) -> void { inflateTracks(); });
+
+    while(result && zipIndex < pack.file.size()) result = iterateExport();
+    tracks->close();
+    inflater.join();
+    tracks.reset();
+  }
+
+  if(result && !cancellation) finishExport();
+  if(result && !cancellation) result = commitStaging();
+  //whichever stage noticed the cancellation first may have failed for it with its own message
+  if(cancellation) result = failure("The export was cancelled.");
+  if(!result) return rollback(), false;
+
+  if(result && duplicates) {
+    information({
+      duplicates, " duplicate file", duplicates == 1 ? "" : "s", " copied: ",
+      bytesSaved / 1024, " KiB not decoded, about ", timeSaved / 1000, " ms saved"
+    });
+  }
+  return result;
+}
+
+//checks every entry in the open pack against its CRC32, writing nothing
+//unlike an export, it does not stop at the first corrupt entry: all of them are listed in corrupt
+auto Exporter::verify() -> bool {
+  error = "";
+  errorLink = "";
+  corrupt.reset();
+
+  bytesDone = 0;
+  bytesTotal = 0;
+  for(auto& file : pack.file) bytesTotal += file.size;
+  for(uint index : range(pack.file.size())) {
+    if(cancellation) return failure("The verification was cancelled.");
+    auto& file = pack.file[index];
+    information({"Verifying ", string{file.name}, "..."});
+    if(!pack.verify(file)) corrupt.append(file.name);
+    bytesDone += file.size;
+    progress(index + 1);
+  }
+
+  if(corrupt) {
+    return failure({
+      corrupt.size(), " file", corrupt.size() == 1 ? " is" : "s are", " corrupt in the MSU1 pack ",
+      "(CRC32 mismatch):\n", corrupt.merge("\n")
+    });
+  }
+  information({"Verified ", pack.file.size(), " files."});
+  return true;
+}
+
+auto Exporter::setDestination() -> void {
+  switch(exportMethod) {
+
+  case ExportMethod::GamePak: {
+    destination = {Location::dir(packPath), outputName, ".sfc/"};
+    break;
+  }
+
+  case ExportMethod::SD2SNES: {
+    if(sd2snesForceManifest) {
+      destination = {Location::dir(packPath), outputName, ".sfc/"};
+    } else {
+      destination = {Location::dir(packPath), "SD2SNES-Snes9x/"};
+    }
+    break;
+  }
+
+  }
+}
+
+auto Exporter::information(const string& text) -> void {
+  if(onInformation) onInformation(text);
+}
+
+auto Exporter::progress(uint files) -> void {
+  if(onProgress) onProgress(files, pack.file.size(), bytesDone, bytesTotal);
+}
+
+auto Exporter::failure(const string& text, const string& link) -> bool {
+  error = text;
+  errorLink = link;
+  return false;
+}
+
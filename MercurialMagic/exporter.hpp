@@ -0,0 +1,136 @@
+#include <nall/nall.hpp>
+using namespace nall;
+
+#include <nall/beat/patch.hpp>
+#include <ramus/ring-buffer.hpp>
+#include <ramus/cancellation-token.hpp>
+
+//the export engine, shared by the GUI and the command-line front-end
+//it has no user interface of its own: progress is reported through callbacks,
+//and failures leave a message in error for the front-end to present
+struct Exporter {
+  enum ExportMethod : uint {
+    GamePak,
+    SD2SNES,
+  };
+
+  //exporter.cpp
+  auto open(const string& packPath) -> bool;
+  auto close() -> void;
+  auto validateROM() -> bool;
+  auto expectedChecksum() const -> uint32_t;
+  auto checksum(const string& path) -> maybe<uint32_t>;
+  auto fetch(string_view name) -> maybe<Decode::ZIP::File>;
+  auto run() -> bool;
+  auto verify() -> bool;
+
+  auto setDestination() -> void;
+  auto information(const string& text) -> void;
+  auto progress(uint files) -> void;
+  auto failure(const string& text, const string& link = "") -> bool;
+
+  //export.cpp
+  auto beginExport() -> bool;
+  auto iterateExport() -> bool;
+  auto finishExport() -> void;
+  auto buildROM(const string& path, const string_vector& patterns) -> bool;
+  auto writeEntry(const string& path, Decode::ZIP::File& entry, bool& damaged) -> bool;
+  auto findDuplicates() -> void;
+  auto trackID(const string& name) -> uint16_t;
+  auto exportPath(const string& name) -> string;
+  auto outputPath(const string& name, const string& path) -> string;
+  auto signature(const Decode::ZIP::File& file) -> string;
+  auto loadExportState() -> void;
+  auto saveExportState() -> void;
+  auto recordName(const string& path) -> string;
+  auto isUnchanged(const string& path, const string& signature) -> bool;
+  auto exportRecord(const string& path, const string& signature) -> void;
+
+  struct ExportRecord {
+    string signature;
+    uint64_t size = 0;
+  };
+
+  //convert.cpp
+  struct Track {
+    const uint8_t* data = nullptr;  //stored entries reference the archive directly
+    uint size = 0;
+    vector<uint8_t> buffer;         //deflated entries are inflated here
+    bool corrupt = false;           //the entry does not match its CRC32
+  };
+
+  auto isTrack(string_view name) -> bool;
+  auto inflateTracks() -> void;
+  auto convert(const string& path, const Track& track, bool& unwritable) -> bool;
+  template<typename Decoder> auto writePCM(const string& path, Decoder& audio, maybe<uint> loop, bool& unwritable) -> bool;
+
+  //cache.cpp
+  auto cacheName() -> string;
+  auto restoreROM(const string& name, const string& targetPath) -> bool;
+  auto storeROM(const string& name, const string& targetPath) -> void;
+  auto evictROMs() -> void;
+
+  //staging.cpp
+  auto sharedDestination() const -> bool;
+  auto beginStaging() -> bool;
+  auto carry(const string& source, const string& target) -> void;
+  auto isOutputName(const string& name) const -> bool;
+  auto stage(const string& path) -> void;
+  auto commitStaging() -> bool;
+  auto rollback() -> void;
+  auto listStaged(const string& path, string_vector& files) -> void;
+
+  //settings
+  string packPath;
+  string romPath;
+  string outputName;
+  ExportMethod exportMethod = ExportMethod::GamePak;
+  bool createManifest = false;
+  bool sd2snesForceManifest = false;
+  bool violateBPS = false;
+  bool detectLoops = false;
+  bool incremental = false;
+  string cacheDirectory = {Path::local(), "MercurialMagic/cache/"};
+  uint64_t cacheLimit = 256 << 20;  //in bytes; 0 disables the cache
+
+  //callbacks, invoked from the thread that calls run()
+  function<void (const string&)> onInformation;
+  function<void (uint, uint, uint64_t, uint64_t)> onProgress;  //files processed, total files, bytes processed, total bytes
+
+  //cancelled from any thread: run() and verify() stop at the next entry or chunk, and return false
+  ramus::CancellationToken cancellation;
+
+  //results
+  string error;
+  string errorLink;  //where to get a missing converter, if that was the cause
+  string destination;
+  uint exported = 0;
+  uint skipped = 0;
+  uint duplicates = 0;      //outputs copied from an identical entry's output
+  uint64_t bytesSaved = 0;  //size of those outputs
+  uint64_t timeSaved = 0;   //estimated, in microseconds: decoding the original minus copying
+  string_vector corrupt;    //entries that do not match their CRC32
+
+  bool hasROM = false;
+  bool hasPatch = false;
+
+private:
+  Decode::ZIP pack;
+  vector<uint8_t> patchContents;
+
+  uint zipIndex;
+  vector<uint16_t> trackIDs;
+  vector<bool> unchanged;    //per archive entry: output is skipped by an incremental export
+  vector<uint> original;     //per archive entry: first entry with identical content
+  vector<uint64_t> elapsed;  //per archive entry: time taken to export it, in microseconds
+  uint64_t bytesDone = 0;    //uncompressed size of the entries processed so far
+  uint64_t bytesTotal = 0;   //uncompressed size of every entry
+  string_vector written;     //outputs this export has started to write
+  string destinationPath;    //where the export is moved once complete; destination names the staging folder until then
+  string stagingRoot;        //holds the staging folder, beside the pack
+  string stagingPath;
+  bool resumed = false;      //the staging folder was left by an incremental export that did not complete
+  map<string, ExportRecord> exportState;
+  unique_pointer<ramus::RingBuffer<Track>> tracks;
+  thread inflater;
+};
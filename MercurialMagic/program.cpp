@@ -2,22 +2,23 @@
 
 unique_pointer<Program> program;
 
-#include "export.cpp"
-#include "convert.cpp"
+#include "exporter.cpp"
 #include "basic-settings.cpp"
 #include "advanced-settings.cpp"
 
 Program::Program(string_vector args) {
   program = this;
-  Application::onMain({&Program::main, this});
 
   icarus = execute("icarus", "--name").output.strip() == "icarus";
   daedalus = execute("daedalus", "--name").output.strip() == "daedalus";
 
-  exportMethod = ExportMethod::GamePak;
-  createManifest = daedalus && !icarus;
-  sd2snesForceManifest = false;
-  violateBPS = false;
+  exporter.createManifest = daedalus && !icarus;
+  exporter.onInformation = [&](const string& text) { post(text); };
+  exporter.onProgress = [&](uint files, uint totalFiles, uint64_t bytes, uint64_t totalBytes) {
+    post(files, totalFiles, bytes, totalBytes);
+  };
+  progressTimer.setEnabled(false);
+  progressTimer.setInterval(50).onActivate({&Program::drain, this});
 
   basicTab.refresh();
   advancedTab.refresh();
@@ -32,24 +33,52 @@ Program::Program(string_vector args) {
     beginExport();
   });
 
-  exitButton.setText("Exit").onActivate({&Program::quit, this});
+  verifyButton.setText("Verify").onActivate([&] {
+    setEnabled(false);
+    beginVerify();
+  });
 
-  onClose({&Program::quit, this});
+  //while an export or verification runs, the timer is enabled, and the exit button cancels it instead
+  exitButton.setText("Exit").onActivate([&] {
+    if(progressTimer.enabled()) return cancel();
+    quit();
+  });
+
+  onClose([&] {
+    if(!progressTimer.enabled()) return quit();
+    quitting = true;
+    cancel();
+  });
 
   args.takeLeft();  //ignore program location in argument parsing
 
+  //options may appear anywhere; the remaining arguments are the pack and ROM paths
+  for(uint n = 0; n < args.size();) {
+    if(args[n] == "--cache-dir" && n + 1 < args.size()) {
+      exporter.cacheDirectory = args[n + 1];
+      if(exporter.cacheDirectory && !exporter.cacheDirectory.endsWith("/")) exporter.cacheDirectory.append("/");
+      args.remove(n, 2);
+    } else if(args[n] == "--cache-size" && n + 1 < args.size()) {
+      exporter.cacheLimit = args[n + 1].natural() << 20;  //in MiB; 0 disables the cache
+      args.remove(n, 2);
+    } else {
+      n++;
+    }
+  }
+
   valid = false;
   if(args) {
     basicTab.packPath.setText(args.takeLeft());
     valid = validatePack();
   }
 
-  if(fetch("patch.bps") && args) {
+  if(exporter.hasPatch && args) {
     basicTab.romPath.setText(args.takeLeft());
     valid = validateROMPatch();
   }
 
   exportButton.setEnabled(valid);
+  verifyButton.setEnabled(exporter.hasROM || exporter.hasPatch);
 
   setVisible(true);
 }
@@ -67,82 +96,165 @@ auto Program::outputName() -> string {
 }
 
 auto Program::validatePack() -> bool {
-  if(!packPath() || !file::exists(packPath())) return false;
+  if(!exporter.open(packPath())) return false;
 
-  pack.open(packPath());
+  basicTab.romLabel.setText(exporter.hasPatch ? "ROM path:" : "No ROM needed");
+  basicTab.romPath.setEnabled(exporter.hasPatch);
+  basicTab.romChange.setEnabled(exporter.hasPatch);
+  if(exporter.hasROM) basicTab.romPath.setText("");
 
-  if(!fetch("msu1.rom")) return false;
-  bool hasROM = !!fetch("program.rom");
-  bool hasPatch = false;
-  if(auto file = fetch("patch.bps")) {
-    patchContents = pack.extract(file());
-    hasPatch = true;
+  return exporter.hasROM || (exporter.hasPatch && validateROMPatch());
+}
+
+auto Program::validateROMPatch() -> bool {
+  exporter.romPath = romPath();
+  if(exporter.validateROM()) return true;
+  if(exporter.error) {
+    warning({
+      exporter.error, "\n\n",
+
+      "If you are attempting to multi-patch (which violates the BPS spec), ",
+      "check the Advanced Settings tab to do so."
+    });
   }
-  if(!hasROM && !hasPatch) return false;
+  return false;
+}
 
-  basicTab.romLabel.setText(hasPatch ? "ROM path:" : "No ROM needed");
-  basicTab.romPath.setEnabled(hasPatch);
-  basicTab.romChange.setEnabled(hasPatch);
-  if(hasROM) basicTab.romPath.setText("");
+//the export runs on its own thread, so that the window stays responsive
+auto Program::beginExport() -> void {
+  exporter.romPath = romPath();
+  exporter.outputName = outputName();
 
-  return hasROM || (hasPatch && validateROMPatch());
+  exporter.cancellation.reset();
+  onFinish = {&Program::finishExport, this};
+  started = chrono::millisecond();
+  progressTimer.setEnabled();
+  worker = thread::create([&](uintptr_t) -> void { finish(exporter.run()); });
 }
 
-auto Program::validateROMPatch() -> bool {
-  if(!romPath() || !file::exists(romPath())) return false;
-
-  if(fetch("patch.bps")) {
-    if(!violateBPS) {
-      uint32_t sourceChecksum = Hash::CRC32(file::read(romPath())).value();
-      uint32_t expectedChecksum = 0;
-      for(uint i : range(4)) {
-        expectedChecksum |= patchContents[patchContents.size() - 12 + i] << (i << 3);
-      }
-      if(sourceChecksum != expectedChecksum) {
-        warning({
-          "The patch is not compatible with this ROM.\n",
-          "Expected CRC32: ", hex(expectedChecksum, 8L).upcase(), "\n\n",
-
-          "If you are attempting to multi-patch (which violates the BPS spec), ",
-          "check the Advanced Settings tab to do so."
-        });
-        return false;
-      }
+//verification writes nothing, so the pack and settings are kept afterwards
+auto Program::beginVerify() -> void {
+  exporter.cancellation.reset();
+  onFinish = {&Program::finishVerify, this};
+  started = chrono::millisecond();
+  progressTimer.setEnabled();
+  worker = thread::create([&](uintptr_t) -> void { finish(exporter.verify()); });
+}
+
+auto Program::finishExport(bool success) -> void {
+  if(exporter.cancellation) {
+    progressBar.setPosition(0);
+    setEnabled(true);
+    return information("Export cancelled.");
+  }
+  if(success) {
+    string summary;
+    if(exporter.duplicates) {
+      summary = {" (", exporter.duplicates, " duplicate file", exporter.duplicates == 1 ? "" : "s", " copied, ",
+        exporter.bytesSaved / 1024, " KiB and about ", exporter.timeSaved / 1000, " ms saved)"};
     }
+    reset();
+    return information({"MSU1 pack exported!", summary});
   }
 
-  return true;
+  if(!exporter.errorLink) return error(exporter.error);
+  string response = error({
+    exporter.error, "\n",
+    #if defined(PLATFORM_WINDOWS)
+    "Would you like to download wav2msu from SMW Central?"
+    #else
+    "Would you like to visit wav2msu's GitHub page?"
+    #endif
+  }, {"Yes", "No"});
+  if(response == "Yes") invoke(exporter.errorLink);
+}
+
+auto Program::finishVerify(bool success) -> void {
+  progressBar.setPosition(0);
+  setEnabled(true);
+  if(exporter.cancellation) return information("Verification cancelled.");
+  if(success) return information("MSU1 pack verified: every file matches its CRC32.");
+  statusLabel.setText("Error");
+  MessageDialog().setTitle("Mercurial Magic").setText(exporter.error).error();
 }
 
-auto Program::setDestination() -> void {
-  switch(exportMethod) {
+//the worker stops at its next check, within one archive entry or chunk, and removes what it had
+//partially written; drain() then sees it finish as usual
+auto Program::cancel() -> void {
+  exporter.cancellation.cancel();
+  exitButton.setEnabled(false);
+  status = "Cancelling...";
+  statusLabel.setText(status);
+}
 
-  case ExportMethod::GamePak: {
-    destination = {Location::dir(packPath()), outputName(), ".sfc/"};
-    break;
-  }
+//worker thread: status and progress events are dropped while the channel is full, since the
+//next ones supersede them; the text is copied, so that no string is shared between threads
+auto Program::post(string text) -> void {
+  Event event;
+  event.type = Event::Type::Status;
+  event.text = string{string_view{text}};
+  events.tryPush(move(event));
+}
 
-  case ExportMethod::SD2SNES: {
-    if(sd2snesForceManifest) {
-      destination = {Location::dir(packPath()), outputName(), ".sfc/"};
-    } else {
-      destination = {Location::dir(packPath()), "SD2SNES-Snes9x/"};
-    }
-    break;
-  }
+auto Program::post(uint files, uint totalFiles, uint64_t bytes, uint64_t totalBytes) -> void {
+  Event event;
+  event.type = Event::Type::Progress;
+  event.files = files;
+  event.totalFiles = totalFiles;
+  event.bytes = bytes;
+  event.totalBytes = totalBytes;
+  events.tryPush(move(event));
+}
 
-  }
+//worker thread: the last event is never dropped; it waits for the UI thread to make room
+auto Program::finish(bool success) -> void {
+  Event event;
+  event.type = Event::Type::Finished;
+  event.success = success;
+  events.push(move(event));
 }
 
-auto Program::fetch(string_view name) -> maybe<Decode::ZIP::File> {
-  for(auto& file : pack.file) {
-    if(file.name.match(name)) return file;
+//UI thread, from progressTimer: applies every pending event, then updates each widget at most once
+auto Program::drain() -> void {
+  Event event;
+  maybe<bool> finished;
+  maybe<uint> position;
+  string rate = throughput;
+  while(!finished && events.tryPop(event)) {
+    switch(event.type) {
+    case Event::Type::Status: {
+      if(!exporter.cancellation) status = move(event.text);  //keeps "Cancelling..." until the end
+      break;
+    }
+    case Event::Type::Progress: {
+      position = event.totalFiles ? event.files * 100 / event.totalFiles : 0;
+      uint64_t elapsed = chrono::millisecond() - started;
+      if(elapsed < 500 || !event.bytes) break;  //too early for a meaningful rate
+      uint64_t perSecond = event.bytes * 1000 / elapsed;
+      uint64_t remaining = perSecond ? (event.totalBytes - event.bytes) / perSecond : 0;
+      throughput = {
+        " (", perSecond >> 20, ".", (perSecond * 10 >> 20) % 10, " MiB/s, ",
+        remaining / 60, ":", pad(remaining % 60, 2, '0'), " remaining)"
+      };
+      break;
+    }
+    case Event::Type::Finished: {
+      finished = event.success;
+      break;
+    }
+    }
   }
-  return nothing;
-}
 
-auto Program::setProgress(uint files) -> void {
-  progressBar.setPosition(files * 100 / pack.file.size());
+  if(position) progressBar.setPosition(position());
+  if(finished) {
+    progressTimer.setEnabled(false);
+    worker.join();
+    status = "";
+    throughput = "";
+    if(quitting) return quit();
+    return onFinish(finished());
+  }
+  if(status != statusLabel.text() || throughput != rate) statusLabel.setText({status, throughput});
 }
 
 auto Program::setEnabled(bool enabled) -> void {
@@ -150,18 +262,18 @@ auto Program::setEnabled(bool enabled) -> void {
   advancedTab.setEnabled(enabled);
 
   exportButton.setEnabled(enabled && validatePack());
+  verifyButton.setEnabled(enabled && (exporter.hasROM || exporter.hasPatch));
+  exitButton.setEnabled(true);
   exitButton.setText(enabled ? "Exit" : "Cancel");
 }
 
 auto Program::reset() -> void {
-  pack.close();
-  pack = {};
+  exporter.close();
 
   basicTab.packPath.setText("");
   basicTab.romPath.setText("");
   basicTab.outputName.setText("");
 
-  trackIDs.reset();
   progressBar.setPosition(0);
   setEnabled(true);
 }
@@ -190,10 +302,6 @@ auto Program::error(const string& text, const string_vector& buttons) -> string
   return MessageDialog().setTitle("Mercurial Magic").setText(text).error(buttons);
 }
 
-auto Program::main() -> void {
-  usleep(2000);
-}
-
 auto Program::quit() -> void {
   setVisible(false);
   Application::quit();
@@ -1,10 +1,8 @@
-#include <nall/nall.hpp>
+#include <exporter.hpp>
+
 #include <hiro/hiro.hpp>
-using namespace nall;
 using namespace hiro;
 
-#include <nall/beat/patch.hpp>
-
 struct BasicTab : TabFrameItem {
   BasicTab(TabFrame*);
 
@@ -39,6 +37,8 @@ struct AdvancedTab : TabFrameItem {
   VerticalLayout layout{this};
     CheckLabel sd2snesForceManifest{&layout, Size{320, 0}};
     CheckLabel violateBPS{&layout, Size{320, 0}};
+    CheckLabel detectLoops{&layout, Size{320, 0}};
+    CheckLabel incrementalExport{&layout, Size{320, 0}};
 
   auto refresh() -> void;
   auto setEnabled(bool enabled = true) -> void;
@@ -47,11 +47,6 @@ struct AdvancedTab : TabFrameItem {
 struct Program : Window {
   Program(string_vector args);
 
-  enum ExportMethod : uint {
-    GamePak,
-    SD2SNES,
-  };
-
   //program.cpp
   auto packPath() -> string;
   auto romPath() -> string;
@@ -60,11 +55,17 @@ struct Program : Window {
   auto validatePack() -> bool;
   auto validateROMPatch() -> bool;
 
-  auto setDestination() -> void;
+  auto beginExport() -> void;
+  auto beginVerify() -> void;
+  auto finishExport(bool success) -> void;
+  auto finishVerify(bool success) -> void;
+  auto cancel() -> void;
 
-  auto fetch(string_view name) -> maybe<Decode::ZIP::File>;
+  auto post(string text) -> void;
+  auto post(uint files, uint totalFiles, uint64_t bytes, uint64_t totalBytes) -> void;
+  auto finish(bool success) -> void;
+  auto drain() -> void;
 
-  auto setProgress(uint files) -> void;
   auto setEnabled(bool enabled = true) -> void;
   auto reset() -> void;
 
@@ -74,17 +75,8 @@ struct Program : Window {
   auto error(const string& text) -> void;
   auto error(const string& text, const string_vector& buttons) -> string;
 
-  auto main() -> void;
   auto quit() -> void;
 
-  //export.cpp
-  auto beginExport() -> void;
-  auto iterateExport() -> bool;
-  auto finishExport() -> void;
-
-  //convert.cpp
-  auto convert(string path) -> bool;
-
   VerticalLayout layout{this};
     TabFrame panel{&layout, Size{~0, ~0}};
       BasicTab basicTab{&panel};
@@ -93,23 +85,35 @@ struct Program : Window {
     ProgressBar progressBar{&layout, Size{~0, 0}};
     HorizontalLayout buttonLayout{&layout, Size{~0, 0}};
       Button exportButton{&buttonLayout, Size{80, 0}};
+      Button verifyButton{&buttonLayout, Size{80, 0}};
       Button exitButton{&buttonLayout, Size{80, 0}};
 
-  ExportMethod exportMethod;
-  bool createManifest;
-  bool sd2snesForceManifest;
-  bool violateBPS;
+  Exporter exporter;
+
+  //the export and verify threads never touch a widget: they post events to this channel,
+  //and progressTimer applies them on the UI thread at a fixed rate
+  struct Event {
+    enum class Type : uint { Status, Progress, Finished } type = Type::Status;
+    string text;             //Status
+    uint files = 0;          //Progress
+    uint totalFiles = 0;
+    uint64_t bytes = 0;
+    uint64_t totalBytes = 0;
+    bool success = false;    //Finished
+  };
+  ramus::RingBuffer<Event> events{256};
+  Timer progressTimer;
+  thread worker;
+  function<void (bool)> onFinish;  //called on the UI thread once the worker is done
+  uint64_t started = 0;            //when the worker began, in milliseconds
+  string status;                   //the latest status text
+  string throughput;               //rate and time remaining, appended to the status text
+  bool quitting = false;           //the window was closed while the worker was running
 
   bool icarus;
   bool daedalus;
 
   bool valid;
-  Decode::ZIP pack;
-  vector<uint8_t> patchContents;
-
-  uint zipIndex;
-  vector<uint16_t> trackIDs;
-  string destination;
 };
 
 extern unique_pointer<Program> program;
@@ -0,0 +1,133 @@
+//transactional export: outputs are written into a staging folder beside the pack, and only moved
+//into the destination once all of them are complete and on disk, so that an export which fails,
+//is cancelled or is interrupted by a crash never leaves a destination that looks complete
+//
+//the staging folder has the destination's own name (e.g. ".Game.part/Game.sfc/"), since icarus
+//and daedalus derive a manifest's type and title from the folder they are given
+//a Game Pak folder belongs to one game, and is replaced as a whole by a single rename; the shared
+//SD2SNES folder is not, so there each output is moved into place, and the ROM last
+
+//true if the destination holds other games' files, and so cannot be replaced as a whole
+auto Exporter::sharedDestination() const -> bool {
+  return exportMethod == ExportMethod::SD2SNES && !sd2snesForceManifest;
+}
+
+//a staging folder left behind is an export that did not complete: an incremental export resumes
+//from the outputs it completed, and any other export starts over
+auto Exporter::beginStaging() -> bool {
+  destinationPath = destination;
+  stagingRoot = {Location::dir(packPath), ".", outputName, ".part/"};
+  stagingPath = {stagingRoot, Location::file(string{destinationPath}.trimRight("/", 1L)), "/"};
+  if(!incremental) directory::remove(stagingRoot);
+  resumed = directory::exists(stagingPath);
+  if(!directory::create(stagingPath)) return false;
+  if(sharedDestination() && !directory::create(destinationPath)) return false;
+
+  carry(destinationPath, stagingPath);
+  destination = stagingPath;
+  return true;
+}
+
+//the destination's existing files (such as save.ram, or outputs an incremental export keeps) are
+//carried over as hard links, or as copies where links are not supported
+//outputs are unlinked before they are rewritten (see stage()), so the destination is never modified
+auto Exporter::carry(const string& source, const string& target) -> void {
+  for(auto& name : directory::contents(source)) {
+    if(name.endsWith("/")) {
+      if(sharedDestination()) continue;
+      directory::create({target, name});
+      carry({source, name}, {target, name});
+      continue;
+    }
+    if(sharedDestination() && !isOutputName(name) && name != ".mercurial-magic.bml") continue;
+    if(file::exists({target, name})) continue;  //already written by the export being resumed
+    if(!file::link({source, name}, {target, name})) file::copy({source, name}, {target, name});
+  }
+}
+
+//in the shared folder: true for this game's outputs (Game.sfc, Game.msu, Game-1.pcm), but not for
+//another game's whose name merely begins with the same text (Game2.sfc)
+auto Exporter::isOutputName(const string& name) const -> bool {
+  if(name.size() <= outputName.size() || !name.beginsWith(outputName)) return false;
+  char next = name[outputName.size()];
+  return next == '.' || next == '-';
+}
+
+//an output is about to be written: it is recorded for rollback, and unlinked from the file it may
+//still share with the destination
+auto Exporter::stage(const string& path) -> void {
+  written.append(path);
+  file::remove(path);
+}
+
+auto Exporter::commitStaging() -> bool {
+  //everything staged reaches the disk before any of it is moved into place
+  string_vector files;
+  listStaged(stagingPath, files);
+  for(auto& path : files) file::sync(path, false);
+  for(auto& path : files) {
+    if(!file::sync(path)) return failure({"Could not write ", string{path}.trimLeft(stagingPath, 1L), " to disk."});
+  }
+  file::sync(stagingPath);
+
+  if(sharedDestination()) {
+    string rom = {outputName, ".sfc"};
+    for(auto& name : directory::files(stagingPath)) {
+      if(name == rom) continue;
+      if(!file::rename({stagingPath, name}, {destinationPath, name})) return failure({"Could not move ", name, " into place."});
+    }
+    if(file::exists({stagingPath, rom}) && !file::rename({stagingPath, rom}, {destinationPath, rom})) {
+      return failure({"Could not move ", rom, " into place."});
+    }
+    file::sync(destinationPath);
+  } else {
+    string source = string{stagingPath}.trimRight("/", 1L);
+    string target = string{destinationPath}.trimRight("/", 1L);
+    if(!directory::exists(destinationPath)) {
+      if(!file::rename(source, target)) return failure("Could not move the export into place.");
+    } else if(!inode::exchange(source, target)) {
+      //without an atomic exchange, the previous export is moved aside first: the destination is
+      //briefly missing, but it is never incomplete
+      string previous = {stagingRoot, "previous"};
+      directory::remove({previous, "/"});  //left by an export that crashed right here
+      if(!file::rename(target, previous)) return failure("Could not move the export into place.");
+      if(!file::rename(source, target)) {
+        file::rename(previous, target);
+        return failure("Could not move the export into place.");
+      }
+    }
+    file::sync(Location::dir(target));
+  }
+
+  //holds nothing but the previous export, if any, by now
+  directory::remove(stagingRoot);
+  written.reset();
+  destination = destinationPath;
+  return true;
+}
+
+//a non-incremental export discards the staging folder; an incremental one keeps the outputs it
+//completed for the next export, and removes only those it had started
+//the staging folder is only left beside the pack if it holds something to resume from
+auto Exporter::rollback() -> void {
+  if(stagingPath && !incremental) {
+    directory::remove(stagingRoot);
+  } else if(stagingPath) {
+    bool completed = resumed;
+    for(auto& path : written) {
+      if(exportState.find(recordName(path))) completed = true;
+      else file::remove(path);
+    }
+    if(completed) saveExportState();
+    else directory::remove(stagingRoot);
+  }
+  written.reset();
+  if(destinationPath) destination = destinationPath;
+}
+
+auto Exporter::listStaged(const string& path, string_vector& files) -> void {
+  for(auto& name : directory::contents(path)) {
+    if(name.endsWith("/")) listStaged({path, name}, files);
+    else files.append({path, name});
+  }
+}
@@ -17,6 +17,16 @@ ScanDialog::ScanDialog() {
     refresh();
   });
   scanList.onActivate([&] { activate(); });
+  scanList.onFetch([&](ListViewItem item, uint position) {
+    auto& name = entries[position];
+    if(name.endsWith("/")) {
+      item.setIcon(Icon::Emblem::Folder).setText(string{name}.trimRight("/"));
+    } else {
+      item.setCheckable().setIcon(Icon::Emblem::File).setText(name);
+    }
+  });
+  scanTimer.setEnabled(false);
+  scanTimer.setInterval(16).onActivate([&] { populate(); });
   selectAllButton.setText("Select All").onActivate([&] {
     for(auto& item : scanList.items()) {
       if(item.checkable()) item.setChecked(true);
@@ -47,27 +57,62 @@ auto ScanDialog::show() -> void {
 
 auto ScanDialog::refresh() -> void {
   scanList.reset();
+  entries.reset();
 
   auto pathname = pathEdit.text().transform("\\", "/");
   if((pathname || Path::root() == "/") && !pathname.endsWith("/")) pathname.append("/");
 
   settings["daedalus/Path"].setValue(pathname);
   pathEdit.setText(pathname);
-  auto contents = directory::icontents(pathname);
 
-  for(auto& name : contents) {
-    if(!name.endsWith("/")) continue;
-    if(gamePakType(Location::suffix(name))) continue;
-    scanList.append(ListViewItem().setIcon(Icon::Emblem::Folder).setText(name.trimRight("/")));
+  //huge folders, and folders on network storage, are read without blocking the user interface
+  uint generation;
+  {
+    std::lock_guard<std::mutex> lock(scan.mutex);
+    generation = ++scan.generation;
+    scan.path = string{string_view{pathname}};
+    scan.result.reset();
   }
+  thread::create([this, generation](uintptr) {
+    thread::detach();
+    string path;
+    {
+      std::lock_guard<std::mutex> lock(scan.mutex);
+      path = string{string_view{scan.path}};
+    }
+    //entries are filtered as they are read, and only those listed are sorted
+    string_vector folders, files;
+    if(!path) folders = directory::ifolders(path);  //the root pseudo-folder, which lists drives
+    else for(auto& entry : directory::scan{path}) {
+      if(entry.folder) {
+        string name{entry.name, "/"};
+        if(!gamePakType(Location::suffix(name))) folders.append(move(name));
+      } else {
+        string name{entry.name};
+        if(gameRomType(Location::suffix(name).downcase())) files.append(move(name));
+      }
+    }
+    folders.isort();
+    files.isort();
+    for(auto& name : files) folders.append(move(name));
 
-  for(auto& name : contents) {
-    if(name.endsWith("/")) continue;
-    if(!gameRomType(Location::suffix(name).downcase())) continue;
-    scanList.append(ListViewItem().setCheckable().setIcon(Icon::Emblem::File).setText(name));
-  }
+    std::lock_guard<std::mutex> lock(scan.mutex);
+    if(generation == scan.generation) scan.result = move(folders);
+  });
+  if(!scanTimer.enabled()) scanTimer.setEnabled();
+}
 
-  Application::processEvents();
+//called by scanTimer: lists the folder once the worker has read it
+//scanList only creates the rows it needs at first, and the rest in the background
+auto ScanDialog::populate() -> void {
+  {
+    std::lock_guard<std::mutex> lock(scan.mutex);
+    if(!scan.result) return;
+    entries = move(scan.result());
+    scan.result.reset();
+  }
+  scanTimer.setEnabled(false);
+  scanList.setItemCount(entries.size());
   scanList.setFocused();
 }
 
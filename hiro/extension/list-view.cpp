@@ -9,6 +9,8 @@ mListView::mListView() {
     }
   });
   append(TableViewHeader().setVisible(false).append(TableViewColumn().setExpandable()));
+  state.timer.setEnabled(false);
+  state.timer.setInterval(16).onActivate([&] { _fetch(mTableView::itemCount() + Page); });
 }
 
 auto mListView::batched() const -> vector<ListViewItem> {
@@ -18,27 +20,45 @@ auto mListView::batched() const -> vector<ListViewItem> {
   return result;
 }
 
+auto mListView::doFetch(ListViewItem item, uint position) const -> void {
+  if(state.onFetch) state.onFetch(item, position);
+}
+
 auto mListView::doToggle(ListViewItem item) const -> void {
   if(state.onToggle) state.onToggle(item);
 }
 
+//in model mode, rows that have not been created yet are created first
 auto mListView::item(uint position) const -> ListViewItem {
+  if(position < state.itemCount) const_cast<mListView*>(this)->_fetch(position + 1);
   return ListViewItem{mTableView::item(position)};
 }
 
+auto mListView::itemCount() const -> uint {
+  return max(state.itemCount, mTableView::itemCount());
+}
+
 auto mListView::items() const -> vector<ListViewItem> {
+  const_cast<mListView*>(this)->_fetch(state.itemCount);
   auto items = mTableView::items();
   vector<ListViewItem> result;
   for(auto item : items) result.append(ListViewItem{item});
   return result;
 }
 
+auto mListView::onFetch(const function<void (ListViewItem, uint)>& callback) -> type& {
+  state.onFetch = callback;
+  return *this;
+}
+
 auto mListView::onToggle(const function<void (ListViewItem)>& callback) -> type& {
   state.onToggle = callback;
   return *this;
 }
 
 auto mListView::reset() -> type& {
+  state.itemCount = 0;
+  state.timer.setEnabled(false);
   mTableView::reset();
   append(TableViewHeader().setVisible(false).append(TableViewColumn().setExpandable()));
   return *this;
@@ -48,4 +68,28 @@ auto mListView::selected() const -> ListViewItem {
   return ListViewItem{mTableView::selected()};
 }
 
+//model mode: the list holds count rows, but only creates them as they are needed
+//the first page is created at once, so that the visible rows appear immediately; the rest are
+//created a page at a time from a timer, so that huge lists never stall the event loop
+//onFetch fills in each row as it is created
+auto mListView::setItemCount(uint count) -> type& {
+  while(mTableView::itemCount() > count) mTableView::remove(mTableView::item(mTableView::itemCount() - 1));
+  state.itemCount = count;
+  _fetch(Page);
+  return *this;
+}
+
+//creates rows up to count; each row is filled in before it is appended, so that the toolkit
+//receives it complete
+auto mListView::_fetch(uint count) -> void {
+  count = min(count, state.itemCount);
+  for(uint position = mTableView::itemCount(); position < count; position++) {
+    ListViewItem item;
+    doFetch(item, position);
+    mTableView::append(item);
+  }
+  bool pending = mTableView::itemCount() < state.itemCount;
+  if(pending != state.timer.enabled()) state.timer.setEnabled(pending);
+}
+
 #endif
@@ -11,16 +11,27 @@ struct mListView : mTableView {
 
   mListView();
   auto batched() const -> vector<ListViewItem>;
+  auto doFetch(ListViewItem item, uint position) const -> void;
   auto doToggle(ListViewItem) const -> void;
   auto item(uint position) const -> ListViewItem;
+  auto itemCount() const -> uint;
   auto items() const -> vector<ListViewItem>;
+  auto onFetch(const function<void (ListViewItem, uint)>& callback) -> type&;
   auto onToggle(const function<void (ListViewItem)>& callback) -> type&;
   auto reset() -> type& override;
   auto selected() const -> ListViewItem;
+  auto setItemCount(uint count) -> type&;
 
 //private:
+  enum : uint { Page = 256 };  //rows created at a time in model mode
+
+  auto _fetch(uint count) -> void;
+
   struct State {
+    uint itemCount = 0;  //model mode: rows in the list, including those not created yet
+    function<void (ListViewItem, uint)> onFetch;
     function<void (ListViewItem)> onToggle;
+    Timer timer;
   } state;
 };
 
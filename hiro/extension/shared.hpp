@@ -68,6 +68,7 @@ struct ListView : sListView {
   auto doActivate() const { return self().doActivate(); }
   auto doChange() const { return self().doChange(); }
   auto doContext() const { return self().doContext(); }
+  auto doFetch(ListViewItem item, uint position) const { return self().doFetch(item, position); }
   auto doToggle(ListViewItem item) const { return self().doToggle(item); }
   auto foregroundColor() const { return self().foregroundColor(); }
   auto item(uint position) const { return self().item(position); }
@@ -76,6 +77,7 @@ struct ListView : sListView {
   auto onActivate(const function<void ()>& callback = {}) { return self().onActivate(callback), *this; }
   auto onChange(const function<void ()>& callback = {}) { return self().onChange(callback), *this; }
   auto onContext(const function<void ()>& callback = {}) { return self().onContext(callback), *this; }
+  auto onFetch(const function<void (ListViewItem, uint)>& callback = {}) { return self().onFetch(callback), *this; }
   auto onToggle(const function<void (ListViewItem)>& callback = {}) { return self().onToggle(callback), *this; }
   auto remove(sListViewItem item) { return self().remove(item), *this; }
   auto reset() { return self().reset(), *this; }
@@ -84,5 +86,6 @@ struct ListView : sListView {
   auto setBackgroundColor(Color color = {}) { return self().setBackgroundColor(color), *this; }
   auto setBatchable(bool batchable = true) { return self().setBatchable(batchable), *this; }
   auto setForegroundColor(Color color = {}) { return self().setForegroundColor(color), *this; }
+  auto setItemCount(uint count = 0) { return self().setItemCount(count), *this; }
 };
 #endif
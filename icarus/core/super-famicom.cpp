@@ -15,8 +15,12 @@ auto Icarus::superFamicomManifest(vector<uint8_t>& buffer, string location) -> s
   string digest = Hash::SHA256(buffer.data(), buffer.size()).digest();
 
   if(settings["icarus/UseDatabase"].boolean() && !markup) {
+    //each entry's lookup builds and discards a few strings: they come from a scratch arena
+    arena scratch;
+    memory::scope scope{&scratch};
     for(auto node : database.superFamicom) {
       if(node["sha256"].text() == digest) {
+        memory::scope heap{nullptr};  //the manifest outlives the arena
         markup.append(node.text(), "\n  sha256:   ", digest, "\n");
         break;
       }
@@ -3,6 +3,7 @@ struct ScanDialog : Window {
 
   auto show() -> void;
   auto refresh() -> void;
+  auto populate() -> void;
   auto activate() -> void;
   auto import() -> void;
 
@@ -22,6 +23,18 @@ struct ScanDialog : Window {
       Widget controlSpacer{&controlLayout, Size{~0, 0}};
       Button settingsButton{&controlLayout, Size{100, 0}};
       Button importButton{&controlLayout, Size{100, 0}};
+
+  //the folder is read on a worker thread; scanTimer hands its result to scanList
+  //reference counts are not atomic here: no string is shared between the user interface and the
+  //worker, so each one is deep-copied or moved across under the mutex
+  struct Scan {
+    std::mutex mutex;
+    uint generation = 0;  //each refresh() starts a new scan, and discards the results of earlier ones
+    string path;          //the folder being read
+    maybe<string_vector> result;
+  } scan;
+  Timer scanTimer;
+  string_vector entries;  //the folders (ending in '/') and files listed in scanList, in order
 };
 
 struct SettingsDialog : Window {
@@ -0,0 +1,132 @@
+#pragma once
+
+//monotonic (bump) allocator for batch operations: one parse, one manifest, one import
+//while a memory::scope on the arena is active, every nall::string and nall::vector allocation on
+//that thread is carved out of a few large chunks; freeing is a no-op, and resizing the most recent
+//allocation extends it in place. everything is released at once by reset() or by destruction
+//
+//objects allocated from the arena must be destroyed before it is reset or destroyed
+//copied strings share their buffer: a result that must outlive the arena is built from a
+//string_view inside a memory::scope on nullptr, which gives it a buffer on the heap
+//
+//  arena scratch;
+//  memory::scope scope{&scratch};
+//  auto document = BML::unserialize(text);
+
+#include <nall/memory.hpp>
+
+namespace nall {
+
+struct arena : memory::allocator {
+  struct Statistics {
+    uint64_t allocations = 0;  //allocations served
+    uint64_t extended = 0;     //resizes done in place
+    uint64_t moved = 0;        //resizes that had to copy
+    uint64_t chunks = 0;       //chunks requested from the heap
+    uint64_t bytes = 0;        //bytes handed out since the last reset
+  };
+
+  arena(uint chunkSize = 64 * 1024) : chunkSize(chunkSize) {}
+  ~arena() { release(nullptr); }
+
+  //keeps the most recent (usually the largest) chunk for the next batch, and frees the others
+  auto reset() -> void {
+    release(chunks);
+    if(chunks) {
+      chunks->next = nullptr;
+      cursor = chunks->data();
+    }
+    last = nullptr;
+    _statistics.bytes = 0;
+  }
+
+  auto statistics() const -> const Statistics& { return _statistics; }
+
+  auto allocate(uint size) -> void* override {
+    auto block = align(cursor);
+    if(!chunks || size > chunks->limit - block) {
+      grow(size);
+      block = align(cursor);
+    }
+    length(block) = size;
+    cursor = block + size;
+    last = block;
+    _statistics.allocations++;
+    _statistics.bytes += size;
+    return block;
+  }
+
+  auto resize(void* target, uint size) -> void* override {
+    auto block = (uint8_t*)target;
+    uint previous = length(block);
+    if(block == last && size <= chunks->limit - block) {
+      if(size > previous) _statistics.bytes += size - previous;
+      length(block) = size;
+      cursor = block + size;
+      _statistics.extended++;
+      return block;
+    }
+    auto result = allocate(size);
+    memory::copy(result, block, min(previous, size));
+    _statistics.moved++;
+    return result;
+  }
+
+  auto free(void* target) -> void override {
+  }
+
+  auto owns(const void* target) const -> bool override {
+    for(auto chunk = chunks; chunk; chunk = chunk->next) {
+      if(target >= chunk->data() && target < chunk->limit) return true;
+    }
+    return false;
+  }
+
+private:
+  struct alignas(16) Chunk {
+    Chunk* next;
+    uint8_t* limit;
+
+    auto data() -> uint8_t* { return (uint8_t*)(this + 1); }
+    auto data() const -> const uint8_t* { return (const uint8_t*)(this + 1); }
+  };
+
+  //blocks are aligned like malloc's, and preceded by their size
+  static auto align(uint8_t* cursor) -> uint8_t* {
+    return (uint8_t*)(((uintptr)cursor + sizeof(uint32_t) + 15) & ~(uintptr)15);
+  }
+
+  static auto length(uint8_t* block) -> uint32_t& {
+    return *(uint32_t*)(block - sizeof(uint32_t));
+  }
+
+  //chunks double in size up to 16MB, so that few are ever needed
+  auto grow(uint size) -> void {
+    uint64_t capacity = max<uint64_t>(chunkSize, (uint64_t)size + 32);
+    auto chunk = (Chunk*)malloc(sizeof(Chunk) + capacity);
+    chunk->limit = chunk->data() + capacity;
+    chunk->next = chunks;
+    chunks = chunk;
+    cursor = chunk->data();
+    if(chunkSize < (16 << 20)) chunkSize <<= 1;
+    _statistics.chunks++;
+  }
+
+  //frees every chunk except keep
+  auto release(Chunk* keep) -> void {
+    for(auto chunk = chunks; chunk;) {
+      auto next = chunk->next;
+      if(chunk != keep) ::free(chunk);
+      chunk = next;
+    }
+    if(!keep) chunks = nullptr;
+  }
+
+  uint64_t chunkSize;
+  Chunk* chunks = nullptr;  //most recent first
+  uint8_t* cursor = nullptr;
+  uint8_t* last = nullptr;  //most recent allocation, which can be extended in place
+  Statistics _statistics;
+};
+
+}
@@ -121,11 +121,11 @@ auto Archive::extract(const string& beatname, const string& filename) -> vector<
   return {};
 }
 
+//sorted, so that archives are reproducible, and each folder precedes its contents
 auto Archive::scan(string_vector& result, const string& basename, const string& pathname) -> void {
-  for(auto& name : directory::contents(pathname)) {
-    result.append(string{pathname, name}.trimLeft(basename, 1L));
-    if(name.endsWith("/")) scan(result, basename, {pathname, name});
-  }
+  string prefix = string{pathname}.trimLeft(basename, 1L);
+  directory::walk(pathname, [&](const string& name) { result.append({prefix, name}); });
+  result.sort();
 }
 
 }}
@@ -157,15 +157,9 @@ protected:
 
   //create() functions
   auto ls(string_vector& list, const string& path, const string& basepath) -> void {
-    auto paths = directory::folders(path);
-    for(auto& pathname : paths) {
-      list.append(string{path, pathname}.trimLeft(basepath, 1L));
-      ls(list, {path, pathname}, basepath);
-    }
-
-    auto files = directory::files(path);
-    for(auto& filename : files) {
-      list.append(string{path, filename}.trimLeft(basepath, 1L));
+    for(auto& name : directory::contents(path)) {
+      list.append(string{path, name}.trimLeft(basepath, 1L));
+      if(name.endsWith("/")) ls(list, {path, name}, basepath);
     }
   }
 
@@ -11,6 +11,7 @@ struct bpspatch {
   inline auto modify(const uint8_t* data, uint size) -> bool;
   inline auto source(const uint8_t* data, uint size) -> void;
   inline auto target(uint8_t* data, uint size) -> void;
+  inline auto setSourceChecksum(uint32_t checksum) -> void;
 
   inline auto modify(const string& filename) -> bool;
   inline auto source(const string& filename) -> bool;
@@ -43,6 +44,7 @@ protected:
   filemap sourceFile;
   const uint8_t* sourceData;
   uint sourceSize;
+  maybe<uint32_t> sourceChecksum;  //CRC32 of the entire source, when already known
 
   filemap targetFile;
   uint8_t* targetData;
@@ -87,6 +89,12 @@ auto bpspatch::modify(const uint8_t* data, uint size) -> bool {
 auto bpspatch::source(const uint8_t* data, uint size) -> void {
   sourceData = data;
   sourceSize = size;
+  sourceChecksum = nothing;
+}
+
+//skips hashing the source in apply() when it is exactly the size the patch expects
+auto bpspatch::setSourceChecksum(uint32_t checksum) -> void {
+  sourceChecksum = checksum;
 }
 
 auto bpspatch::target(uint8_t* data, uint size) -> void {
@@ -202,9 +210,10 @@ auto bpspatch::apply() -> result {
   uint32_t checksum = modifyChecksum.digest().hex();
   for(uint n = 0; n < 32; n += 8) modifyModifyChecksum |= read() << n;
 
-  uint32_t sourceChecksum = Hash::CRC32(sourceData, modifySourceSize).digest().hex();
+  uint32_t checksumSource = sourceChecksum && sourceSize == modifySourceSize
+  ? sourceChecksum() : Hash::CRC32(sourceData, modifySourceSize).value();
 
-  if(sourceChecksum != modifySourceChecksum) return result::source_checksum_invalid;
+  if(checksumSource != modifySourceChecksum) return result::source_checksum_invalid;
   if(targetChecksum.digest().hex() != modifyTargetChecksum) return result::target_checksum_invalid;
   if(checksum != modifyModifyChecksum) return result::patch_checksum_invalid;
 
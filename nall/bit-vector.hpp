@@ -33,7 +33,7 @@ struct bitvector {
   auto data() const -> const uint8_t* { return pool; }
 
   auto reset() -> void {
-    if(pool) free(pool);
+    if(pool) memory::free(pool);
     pool = nullptr;
     bits = 0;
   }
@@ -1,13 +1,15 @@
 #pragma once
 
 #include <setjmp.h>
+#include <nall/hash/crc32.hpp>
 
 namespace nall { namespace Decode {
 
 namespace puff {
   inline auto puff(
     unsigned char* dest, unsigned long* destlen,
-    unsigned char* source, unsigned long* sourcelen
+    unsigned char* source, unsigned long* sourcelen,
+    Hash::CRC32* checksum = nullptr
   ) -> int;
 }
 
@@ -20,6 +22,17 @@ inline auto inflate(
   return result == 0;
 }
 
+//also hashes the output as it is produced, while each chunk is still in cache
+inline auto inflate(
+  uint8_t* target, uint targetLength,
+  const uint8_t* source, uint sourceLength,
+  Hash::CRC32& checksum
+) -> bool {
+  unsigned long tl = targetLength, sl = sourceLength;
+  int result = puff::puff((unsigned char*)target, &tl, (unsigned char*)source, &sl, &checksum);
+  return result == 0;
+}
+
 namespace puff {
 
 enum : uint {
@@ -28,6 +41,7 @@ enum : uint {
   MAXDCODES =  30,
   FIXLCODES = 288,
   MAXCODES  = MAXLCODES + MAXDCODES,
+  HASHCHUNK = 32768,  //output is hashed in chunks of at least this size
 };
 
 struct state {
@@ -41,9 +55,19 @@ struct state {
   int bitbuf;
   int bitcnt;
 
+  Hash::CRC32* checksum;
+  unsigned long hashed;
+
   jmp_buf env;
 };
 
+//hashes the output produced since the last call
+inline auto hash(state* s) -> void {
+  if(s->checksum == nullptr || s->out == nullptr) return;
+  s->checksum->input(s->out + s->hashed, s->outcnt - s->hashed);
+  s->hashed = s->outcnt;
+}
+
 struct huffman {
   short* count;
   short* symbol;
@@ -82,6 +106,7 @@ inline auto stored(state* s) -> int {
   if(s->out != nullptr) {
     if(s->outcnt + len > s->outlen) return 1;
     while(len--) s->out[s->outcnt++] = s->in[s->incnt++];
+    if(s->outcnt - s->hashed >= HASHCHUNK) hash(s);
   } else {
     s->outcnt += len;
     s->incnt += len;
@@ -173,6 +198,7 @@ inline auto codes(state* s, huffman* lencode, huffman* distcode) -> int {
   };
 
   do {
+    if(s->outcnt - s->hashed >= HASHCHUNK) hash(s);
     symbol = decode(s, lencode);
     if(symbol < 0) return symbol;
     if(symbol < 256) {
@@ -304,7 +330,8 @@ inline auto dynamic(state* s) -> int {
 
 inline auto puff(
   unsigned char* dest, unsigned long* destlen,
-  unsigned char* source, unsigned long* sourcelen
+  unsigned char* source, unsigned long* sourcelen,
+  Hash::CRC32* checksum
 ) -> int {
   state s;
   int last, type, err;
@@ -319,6 +346,9 @@ inline auto puff(
   s.bitbuf = 0;
   s.bitcnt = 0;
 
+  s.checksum = checksum;
+  s.hashed = 0;
+
   if(setjmp(s.env) != 0) {
     err = 2;
   } else {
@@ -333,6 +363,8 @@ inline auto puff(
     } while(!last);
   }
 
+  if(err == 0) hash(&s);
+
   if(err <= 0) {
     *destlen = s.outcnt;
     *sourcelen = s.incnt;
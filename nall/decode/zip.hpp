@@ -4,17 +4,23 @@
 #include <nall/string.hpp>
 #include <nall/vector.hpp>
 #include <nall/decode/inflate.hpp>
+#include <nall/hash/crc32.hpp>
 
 namespace nall { namespace Decode {
 
 struct ZIP {
   struct File {
-    string name;
-    const uint8_t* data;
-    uint size;
-    uint csize;
+    string_view name;  //view into the central directory; not NUL-terminated
+    const uint8_t* header;  //local file header
+    uint64_t size;
+    uint64_t csize;
     uint cmode;  //0 = uncompressed, 8 = deflate
     uint crc32;
+
+    //the local header is only read here, so that open() does not touch every entry's page
+    auto data() const -> const uint8_t* {
+      return header + 30 + (header[26] | header[27] << 8) + (header[28] | header[29] << 8);
+    }
   };
 
   ~ZIP() {
@@ -31,26 +37,41 @@ struct ZIP {
     return true;
   }
 
-  auto open(const uint8_t* data, uint size) -> bool {
+  auto open(const uint8_t* data, uint64_t size) -> bool {
     if(size < 22) return false;
 
     filedata = data;
     filesize = size;
 
     file.reset();
+    index.reset();
 
+    //the end of central directory record is followed only by a comment of at most 65535 bytes
     const uint8_t* footer = data + size - 22;
-    while(true) {
-      if(footer <= data + 22) return false;
+    const uint8_t* limit = data + (size > 22 + 65535 ? size - 22 - 65535 : 0);
+    while(footer >= limit) {
+      footer = (const uint8_t*)findLast(limit, footer + 1 - limit, 'P');
+      if(!footer || footer < data) return false;
       if(read(footer, 4) == 0x06054b50) {
         uint commentlength = read(footer + 20, 2);
         if(footer + 22 + commentlength == data + size) break;
       }
       footer--;
     }
-    const uint8_t* directory = data + read(footer + 16, 4);
+    if(footer < limit) return false;
+    uint64_t directoryOffset = read(footer + 16, 4);
+
+    //ZIP64: the end of central directory locator precedes the end of central directory record
+    if(footer - data >= 20 && read(footer - 20, 4) == 0x07064b50) {
+      uint64_t recordOffset = read(footer - 20 + 8, 8);
+      if(recordOffset > size || size - recordOffset < 56) return false;  //recordOffset may be any 64-bit value
+      if(read(data + recordOffset, 4) != 0x06064b50) return false;
+      directoryOffset = read(data + recordOffset + 48, 8);
+    }
+    if(directoryOffset >= size) return false;
+    const uint8_t* directory = data + directoryOffset;
 
-    while(true) {
+    while(footer - directory >= 46) {
       uint signature = read(directory + 0, 4);
       if(signature != 0x02014b50) break;
 
@@ -63,42 +84,158 @@ struct ZIP {
       uint namelength = read(directory + 28, 2);
       uint extralength = read(directory + 30, 2);
       uint commentlength = read(directory + 32, 2);
+      uint64_t offset = read(directory + 42, 4);
+      if(footer - directory < 46 + namelength + extralength) return false;
+
+      //ZIP64 extended information: 64-bit values for whichever fields are saturated, in this order
+      const uint8_t* extra = directory + 46 + namelength;
+      const uint8_t* extraEnd = extra + extralength;
+      while(extraEnd - extra >= 4) {
+        uint tag = read(extra + 0, 2);
+        uint length = read(extra + 2, 2);
+        const uint8_t* field = extra + 4;
+        const uint8_t* fieldEnd = field + min(length, (uint)(extraEnd - field));
+        if(tag == 0x0001) {
+          if(file.size  == 0xffffffff && fieldEnd - field >= 8) file.size  = read(field, 8), field += 8;
+          if(file.csize == 0xffffffff && fieldEnd - field >= 8) file.csize = read(field, 8), field += 8;
+          if(offset     == 0xffffffff && fieldEnd - field >= 8) offset     = read(field, 8), field += 8;
+        }
+        extra += 4 + length;
+      }
 
-      char* filename = new char[namelength + 1];
-      memcpy(filename, directory + 46, namelength);
-      filename[namelength] = 0;
-      file.name = filename;
-      delete[] filename;
+      file.name = string_view{(const char*)directory + 46, namelength};
 
-      uint offset = read(directory + 42, 4);
-      uint offsetNL = read(data + offset + 26, 2);
-      uint offsetEL = read(data + offset + 28, 2);
-      file.data = data + offset + 30 + offsetNL + offsetEL;
+      if(offset > size || size - offset < 30) return false;
+      file.header = data + offset;
 
       directory += 46 + namelength + extralength + commentlength;
 
-      this->file.append(file);
+      this->file.append(move(file));
+    }
+
+    //open addressing hash table of entry indices (+1, so that 0 marks an empty slot)
+    //hashes are kept beside the indices, so that probing rarely touches the entries themselves
+    uint slots = 16;
+    while(slots < this->file.size() * 2) slots <<= 1;
+    index.resize(slots);
+    for(uint n : range(this->file.size())) {
+      auto& name = this->file[n].name;
+      uint32_t hash = this->hash(name);
+      for(uint slot = hash & (slots - 1);; slot = (slot + 1) & (slots - 1)) {
+        if(!index[slot].entry) { index[slot] = {hash, n + 1}; break; }
+        //duplicate names resolve to the first entry
+        if(index[slot].hash == hash && equal(this->file[index[slot].entry - 1].name, name)) break;
+      }
     }
 
     return true;
   }
 
+  //exact name lookup
+  auto find(string_view name) -> maybe<File&> {
+    if(!index) return nothing;
+    uint mask = index.size() - 1;
+    uint32_t hash = this->hash(name);
+    for(uint slot = hash & mask; index[slot].entry; slot = (slot + 1) & mask) {
+      if(index[slot].hash != hash) continue;
+      auto& entry = file[index[slot].entry - 1];
+      if(equal(entry.name, name)) return entry;
+    }
+    return nothing;
+  }
+
+  //iterates over entries matching a pattern ('*' and '?' wildcards), in archive order
+  //the pattern is compiled once; patterns without wildcards use find()
+  struct Matches {
+    struct iterator {
+      auto operator*() -> File& { return matches.zip.file[offset]; }
+      auto operator!=(const iterator& source) const -> bool { return offset != source.offset; }
+      auto operator++() -> iterator& { offset = matches.next(offset + 1); return *this; }
+
+      const Matches& matches;
+      uint offset;
+    };
+
+    auto begin() const -> iterator { return {*this, next(0)}; }
+    auto end() const -> iterator { return {*this, zip.file.size()}; }
+
+  private:
+    Matches(ZIP& zip, string_view pattern) : zip(zip), pattern(pattern) {
+      if(this->pattern.literal()) {
+        if(auto entry = zip.find(pattern)) literal = entry.data() - zip.file.data();
+        else literal = zip.file.size();
+      }
+    }
+
+    auto next(uint offset) const -> uint {
+      if(literal) return offset <= literal() ? literal() : zip.file.size();
+      for(; offset < zip.file.size(); offset++) {
+        if(pattern.match(zip.file[offset].name)) return offset;
+      }
+      return offset;
+    }
+
+    ZIP& zip;
+    string_pattern pattern;
+    maybe<uint> literal;
+    friend struct ZIP;
+  };
+
+  auto match(string_view pattern) -> Matches {
+    return {*this, pattern};
+  }
+
+  //entries must fit in memory; stored entries of any size can instead be read through File::data
   auto extract(File& file) -> vector<uint8_t> {
     vector<uint8_t> buffer;
+    if(file.size > ~0u) return buffer;
+    buffer.resize(file.size);
+    if(extract(file, buffer.data()) == false) buffer.reset();
+    return buffer;
+  }
+
+  //extracts into a caller-provided buffer of at least file.size bytes (e.g. a mapped output file)
+  //fails if the output does not match the entry's CRC32, which is computed chunk by chunk as the
+  //output is copied or inflated, while each chunk is still in cache
+  auto extract(File& file, uint8_t* target) -> bool {
+    if(file.size > ~0u) return false;
+    const uint8_t* data = contents(file);
+    if(!data) return false;
 
+    Hash::CRC32 checksum;
     if(file.cmode == 0) {
-      buffer.resize(file.size);
-      memcpy(buffer.data(), file.data, file.size);
+      for(uint64_t offset = 0; offset < file.size; offset += Chunk) {
+        uint length = min<uint64_t>(Chunk, file.size - offset);
+        memcpy(target + offset, data + offset, length);
+        checksum.input(target + offset, length);
+      }
+    } else if(file.cmode == 8) {
+      if(!inflate(target, file.size, data, file.csize, checksum)) return false;
+    } else {
+      return false;
     }
+    return checksum.value() == file.crc32;
+  }
 
-    if(file.cmode == 8) {
-      buffer.resize(file.size);
-      if(inflate(buffer.data(), buffer.size(), file.data, file.csize) == false) {
-        buffer.reset();
-      }
+  //checks an entry against its CRC32 without keeping its contents
+  auto verify(File& file) -> bool {
+    if(file.cmode == 0) {
+      const uint8_t* data = contents(file);
+      return data && Hash::CRC32(data, file.size).value() == file.crc32;
     }
+    if(file.size > ~0u) return false;
+    vector<uint8_t> buffer;
+    buffer.resize(file.size);
+    return extract(file, buffer.data());
+  }
 
-    return buffer;
+  //the entry's bytes within the archive mapping, or nullptr if the headers place them outside it
+  //for stored entries, at least file.size bytes are available
+  auto contents(File& file) const -> const uint8_t* {
+    const uint8_t* data = file.data();
+    if(data > filedata + filesize || file.csize > filedata + filesize - data) return nullptr;
+    if(file.cmode == 0 && file.csize < file.size) return nullptr;
+    return data;
   }
 
   auto close() -> void {
@@ -106,16 +243,43 @@ struct ZIP {
   }
 
 protected:
+  enum : uint { Chunk = 65536 };  //copy and checksum granularity; small enough to stay in cache
+
   filemap fm;
   const uint8_t* filedata;
-  uint filesize;
+  uint64_t filesize;
 
-  auto read(const uint8_t* data, uint size) -> uint {
-    uint result = 0, shift = 0;
-    while(size--) { result |= *data++ << shift; shift += 8; }
+  struct Slot { uint32_t hash; uint entry; };
+  vector<Slot> index;
+
+  auto read(const uint8_t* data, uint size) -> uint64_t {
+    uint64_t result = 0, shift = 0;
+    while(size--) { result |= (uint64_t)*data++ << shift; shift += 8; }
     return result;
   }
 
+  //memrchr where available
+  static auto findLast(const void* data, size_t size, uint8_t byte) -> const void* {
+    #if defined(__GLIBC__)
+    return memrchr(data, byte, size);
+    #else
+    auto p = (const uint8_t*)data + size;
+    while(p != data) if(*--p == byte) return p;
+    return nullptr;
+    #endif
+  }
+
+  //FNV-1a
+  static auto hash(const string_view& name) -> uint32_t {
+    uint32_t result = 0x811c9dc5;
+    for(uint n : range(name.size())) result = (result ^ (uint8_t)name.data()[n]) * 0x01000193;
+    return result;
+  }
+
+  static auto equal(const string_view& x, const string_view& y) -> bool {
+    return x.size() == y.size() && !memory::compare(x.data(), y.data(), x.size());
+  }
+
 public:
   vector<File> file;
 };
@@ -5,16 +5,26 @@
 #include <nall/intrinsics.hpp>
 #include <nall/sort.hpp>
 #include <nall/string.hpp>
+#include <nall/thread.hpp>
 #include <nall/vector.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 #if defined(PLATFORM_WINDOWS)
   #include <nall/windows/utf8.hpp>
 #else
   #include <dirent.h>
+  #include <fcntl.h>
   #include <stdio.h>
   #include <sys/types.h>
 #endif
 
+#if defined(PLATFORM_LINUX)
+  #include <sys/syscall.h>
+#endif
+
 namespace nall {
 
 struct directory : inode {
@@ -35,8 +45,8 @@ struct directory : inode {
   }
 
   static auto contents(const string& pathname, const string& pattern = "*") -> string_vector {
-    auto folders = directory::ufolders(pathname);  //pattern search of contents should only filter files
-    auto files = directory::ufiles(pathname, pattern);
+    string_vector folders, files;
+    directory::ucontents(pathname, pattern, folders, files);
     folders.sort();
     files.sort();
     for(auto& file : files) folders.append(file);
@@ -56,18 +66,75 @@ struct directory : inode {
   }
 
   static auto icontents(const string& pathname, const string& pattern = "*") -> string_vector {
-    auto folders = directory::ufolders(pathname);  //pattern search of contents should only filter files
-    auto files = directory::ufiles(pathname, pattern);
+    string_vector folders, files;
+    directory::ucontents(pathname, pattern, folders, files);
     folders.isort();
     files.isort();
     for(auto& file : files) folders.append(file);
     return folders;
   }
 
+  //iterates over the entries of one folder, unsorted, in the order the file system returns them
+  //each entry's type comes from the listing itself: only symbolic links, and file systems that do
+  //not report types, need a stat call. names are valid until the scan advances
+  //
+  //  for(auto& entry : directory::scan{pathname}) print(entry.name, entry.folder ? "/" : "", "\n");
+  struct scan {
+    struct entry {
+      const char* name = nullptr;
+      bool folder = false;
+      bool link = false;  //a symbolic link (or reparse point); folder describes its target
+    };
+
+    struct iterator {
+      auto operator*() const -> const entry& { return owner->current; }
+      auto operator!=(const iterator& source) const -> bool { return done() != source.done(); }
+      auto operator++() -> iterator& { owner->next(); return *this; }
+      auto done() const -> bool { return !owner || !owner->current.name; }  //end() has no owner
+      scan* owner;
+    };
+
+    inline scan(const string& pathname);
+    inline ~scan();
+    scan(const scan&) = delete;
+    auto operator=(const scan&) -> scan& = delete;
+
+    explicit operator bool() const { return opened; }
+    auto begin() -> iterator { next(); return {this}; }
+    auto end() -> iterator { return {nullptr}; }
+    inline auto next() -> bool;
+
+  private:
+    entry current;
+    bool opened = false;
+    #if defined(PLATFORM_WINDOWS)
+    HANDLE handle = INVALID_HANDLE_VALUE;
+    WIN32_FIND_DATA data;
+    bool pending = false;  //data holds an entry that has not been returned yet
+    string name;
+    #elif defined(PLATFORM_LINUX)
+    enum : uint { BufferSize = 64 * 1024 };  //large reads save round trips on network file systems
+    int fd = -1;
+    uint8_t* buffer = nullptr;
+    uint offset = 0;
+    uint length = 0;
+    #else
+    DIR* dp = nullptr;
+    #endif
+  };
+
+  //calls callback with the path, relative to pathname, of every folder and file below it
+  //folder paths end with '/'. a folder is always reported before its contents, in no other order
+  //linked folders are reported, but not entered: a link may lead back to one of its own parents
+  //with several threads, idle threads steal unscanned folders from busy ones, and callback is
+  //invoked from all of them at once: it must be thread-safe
+  static auto walk(const string& pathname, const function<void (const string& name)>& callback, uint threads = 1) -> void;
+
 private:
   //internal functions; these return unsorted lists
   static auto ufolders(const string& pathname, const string& pattern = "*") -> string_vector;
   static auto ufiles(const string& pathname, const string& pattern = "*") -> string_vector;
+  static auto ucontents(const string& pathname, const string& pattern, string_vector& folders, string_vector& files) -> void;
 };
 
 #if defined(PLATFORM_WINDOWS)
@@ -114,6 +181,7 @@ private:
     }
 
     string_vector list;
+    string_pattern filter{pattern};
     string path = pathname;
     path.transform("/", "\\");
     if(!path.endsWith("\\")) path.append("\\");
@@ -125,14 +193,14 @@ private:
       if(wcscmp(data.cFileName, L".") && wcscmp(data.cFileName, L"..")) {
         if(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
           string name = (const char*)utf8_t(data.cFileName);
-          if(name.match(pattern)) list.append(name);
+          if(filter.match(name)) list.append(name);
         }
       }
       while(FindNextFile(handle, &data) != false) {
         if(wcscmp(data.cFileName, L".") && wcscmp(data.cFileName, L"..")) {
           if(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
             string name = (const char*)utf8_t(data.cFileName);
-            if(name.match(pattern)) list.append(name);
+            if(filter.match(name)) list.append(name);
           }
         }
       }
@@ -146,6 +214,7 @@ private:
     if(!pathname) return {};
 
     string_vector list;
+    string_pattern filter{pattern};
     string path = pathname;
     path.transform("/", "\\");
     if(!path.endsWith("\\")) path.append("\\");
@@ -156,30 +225,73 @@ private:
     if(handle != INVALID_HANDLE_VALUE) {
       if((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
         string name = (const char*)utf8_t(data.cFileName);
-        if(name.match(pattern)) list.append(name);
+        if(filter.match(name)) list.append(name);
       }
       while(FindNextFile(handle, &data) != false) {
         if((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
           string name = (const char*)utf8_t(data.cFileName);
-          if(name.match(pattern)) list.append(name);
+          if(filter.match(name)) list.append(name);
         }
       }
       FindClose(handle);
     }
     return list;
   }
+
+  inline directory::scan::scan(const string& pathname) {
+    string path = pathname;
+    path.transform("/", "\\");
+    if(!path.endsWith("\\")) path.append("\\");
+    path.append("*");
+    handle = FindFirstFile(utf16_t(path), &data);
+    opened = pending = handle != INVALID_HANDLE_VALUE;
+  }
+
+  inline directory::scan::~scan() {
+    if(handle != INVALID_HANDLE_VALUE) FindClose(handle);
+  }
+
+  inline auto directory::scan::next() -> bool {
+    current = {};
+    while(handle != INVALID_HANDLE_VALUE) {
+      if(!pending && FindNextFile(handle, &data) == false) {
+        FindClose(handle);
+        handle = INVALID_HANDLE_VALUE;
+        break;
+      }
+      pending = false;
+      if(!wcscmp(data.cFileName, L".") || !wcscmp(data.cFileName, L"..")) continue;
+      name = (const char*)utf8_t(data.cFileName);
+      current.name = name.data();
+      current.folder = data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY;
+      current.link = data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT;
+      return true;
+    }
+    return false;
+  }
 #else
-  inline auto directory_is_folder(DIR* dp, struct dirent* ep) -> bool {
-    if(ep->d_type == DT_DIR) return true;
-    if(ep->d_type == DT_LNK || ep->d_type == DT_UNKNOWN) {
-      //symbolic links must be resolved to determine type
+  //symbolic links must be resolved to determine type
+  inline auto directory_is_folder(int fd, const char* name, uint type, bool& link) -> bool {
+    if(type == DT_DIR) return true;
+    if(type == DT_UNKNOWN) {
       struct stat sp = {0};
-      fstatat(dirfd(dp), ep->d_name, &sp, 0);
+      fstatat(fd, name, &sp, AT_SYMLINK_NOFOLLOW);
+      if(!S_ISLNK(sp.st_mode)) return S_ISDIR(sp.st_mode);
+      type = DT_LNK;
+    }
+    if(type == DT_LNK) {
+      struct stat sp = {0};
+      fstatat(fd, name, &sp, 0);
+      link = true;
       return S_ISDIR(sp.st_mode);
     }
     return false;
   }
 
+  inline auto directory_is_dot(const char* name) -> bool {
+    return name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2]));
+  }
+
   inline auto directory::create(const string& pathname, uint permissions) -> bool {
     string path;
     auto list = string{pathname}.trimRight("/").split("/");
@@ -211,20 +323,10 @@ private:
     if(!pathname) return string_vector{"/"};
 
     string_vector list;
-    DIR* dp;
-    struct dirent* ep;
-    dp = opendir(pathname);
-    if(dp) {
-      while(ep = readdir(dp)) {
-        if(!strcmp(ep->d_name, ".")) continue;
-        if(!strcmp(ep->d_name, "..")) continue;
-        if(!directory_is_folder(dp, ep)) continue;
-        string name{ep->d_name};
-        if(name.match(pattern)) list.append(std::move(name));
-      }
-      closedir(dp);
+    string_pattern filter{pattern};
+    for(auto& entry : scan{pathname}) {
+      if(entry.folder && filter.match(entry.name)) list.append(string{entry.name, "/"});
     }
-    for(auto& name : list) name.append("/");  //must append after sorting
     return list;
   }
 
@@ -232,21 +334,147 @@ private:
     if(!pathname) return {};
 
     string_vector list;
-    DIR* dp;
-    struct dirent* ep;
+    string_pattern filter{pattern};
+    for(auto& entry : scan{pathname}) {
+      if(!entry.folder && filter.match(entry.name)) list.append(entry.name);
+    }
+    return list;
+  }
+
+  #if defined(PLATFORM_LINUX)
+  //getdents64 returns as many entries as fit in the buffer in one call; readdir's buffer is smaller
+  inline directory::scan::scan(const string& pathname) {
+    fd = ::open(pathname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(fd < 0) return;
+    buffer = (uint8_t*)malloc(BufferSize);
+    opened = true;
+  }
+
+  inline directory::scan::~scan() {
+    if(fd >= 0) ::close(fd);
+    ::free(buffer);
+  }
+
+  inline auto directory::scan::next() -> bool {
+    current = {};
+    while(fd >= 0) {
+      if(offset >= length) {
+        long count = syscall(SYS_getdents64, fd, buffer, BufferSize);
+        if(count <= 0) {
+          ::close(fd);
+          fd = -1;
+          break;
+        }
+        offset = 0;
+        length = count;
+      }
+      auto record = (struct dirent64*)(buffer + offset);
+      offset += record->d_reclen;
+      if(directory_is_dot(record->d_name)) continue;
+      current.name = record->d_name;
+      current.folder = directory_is_folder(fd, record->d_name, record->d_type, current.link);
+      return true;
+    }
+    return false;
+  }
+  #else
+  inline directory::scan::scan(const string& pathname) {
     dp = opendir(pathname);
-    if(dp) {
-      while(ep = readdir(dp)) {
-        if(!strcmp(ep->d_name, ".")) continue;
-        if(!strcmp(ep->d_name, "..")) continue;
-        if(directory_is_folder(dp, ep)) continue;
-        string name{ep->d_name};
-        if(name.match(pattern)) list.append(std::move(name));
+    opened = dp;
+  }
+
+  inline directory::scan::~scan() {
+    if(dp) closedir(dp);
+  }
+
+  inline auto directory::scan::next() -> bool {
+    current = {};
+    while(dp) {
+      auto ep = readdir(dp);
+      if(!ep) {
+        closedir(dp);
+        dp = nullptr;
+        break;
       }
-      closedir(dp);
+      if(directory_is_dot(ep->d_name)) continue;
+      current.name = ep->d_name;
+      current.folder = directory_is_folder(dirfd(dp), ep->d_name, ep->d_type, current.link);
+      return true;
     }
-    return list;
+    return false;
   }
+  #endif
 #endif
 
+//one scan yields both lists; the pattern only filters files
+inline auto directory::ucontents(const string& pathname, const string& pattern, string_vector& folders, string_vector& files) -> void {
+  if(!pathname) {
+    folders = ufolders(pathname);
+    return;
+  }
+
+  string_pattern filter{pattern};
+  for(auto& entry : scan{pathname}) {
+    if(entry.folder) folders.append(string{entry.name, "/"});
+    else if(filter.match(entry.name)) files.append(entry.name);
+  }
+}
+
+inline auto directory::walk(const string& pathname, const function<void (const string&)>& callback, uint threads) -> void {
+  struct Worker {
+    std::mutex mutex;
+    vector<string> folders;  //waiting to be scanned: the owner takes the newest, thieves the oldest
+  };
+  threads = max(1u, threads);
+  auto workers = new Worker[threads];
+  std::atomic<uint> pending{1};  //folders queued or being scanned
+  std::mutex idle;
+  std::condition_variable wake;
+  workers[0].folders.append("");
+
+  auto take = [&](uint self, string& folder) -> bool {
+    for(uint n : range(threads)) {
+      auto& worker = workers[(self + n) % threads];
+      std::lock_guard<std::mutex> lock(worker.mutex);
+      if(!worker.folders) continue;
+      folder = n == 0 ? worker.folders.takeRight() : worker.folders.takeLeft();
+      return true;
+    }
+    return false;
+  };
+
+  auto work = [&](uintptr self) -> void {
+    string folder;
+    while(pending) {
+      if(!take(self, folder)) {
+        //the timeout covers a wakeup sent between take() failing and the wait beginning
+        std::unique_lock<std::mutex> lock(idle);
+        wake.wait_for(lock, std::chrono::milliseconds(1));
+        continue;
+      }
+      for(auto& entry : scan{string{pathname, folder}}) {
+        string name{folder, entry.name};
+        if(entry.folder) {
+          name.append("/");
+          callback(name);
+          if(entry.link) continue;
+          pending++;
+          std::lock_guard<std::mutex> lock(workers[self].mutex);
+          workers[self].folders.append(name);
+          wake.notify_one();
+        } else {
+          callback(name);
+        }
+      }
+      if(--pending == 0) wake.notify_all();
+    }
+  };
+
+  vector<thread> helpers;
+  for(uint n : range(1, threads)) helpers.append(thread::create(work, n));
+  work(0);
+  for(auto& helper : helpers) helper.join();
+  delete[] workers;
+}
+
 }
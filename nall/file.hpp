@@ -8,19 +8,72 @@
 #include <nall/varint.hpp>
 #include <nall/hash/sha256.hpp>
 
+#if defined(PLATFORM_LINUX)
+  #include <linux/fs.h>
+  #include <sys/ioctl.h>
+  #include <sys/sendfile.h>
+#endif
+
 namespace nall {
 
 struct file : inode, varint {
   enum class mode : uint { read, write, modify, append, readwrite = modify, writeread = append };
   enum class index : uint { absolute, relative };
+  enum class method : uint { none, clone, range, sendfile, buffer };  //fastest to slowest copy method
 
   static auto copy(const string& sourcename, const string& targetname) -> bool {
+    method used;
+    return copy(sourcename, targetname, used);
+  }
+
+  //used reports the slowest method that was needed, for diagnostics
+  static auto copy(const string& sourcename, const string& targetname, method& used) -> bool {
+    used = method::none;
     if(sourcename == targetname) return true;
+
+    #if defined(PLATFORM_LINUX)
+    int rd = ::open(sourcename, O_RDONLY);
+    if(rd < 0) return false;
+    struct stat data;
+    if(fstat(rd, &data) != 0 || !S_ISREG(data.st_mode)) return ::close(rd), false;
+    int wr = ::open(targetname, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if(wr < 0) return ::close(rd), false;
+
+    //a reflink shares extents copy-on-write, and keeps holes
+    bool result = true;
+    if(ioctl(wr, FICLONE, rd) == 0) {
+      used = method::clone;
+    } else if(ftruncate(wr, data.st_size) != 0) {
+      result = false;
+    } else {
+      //copy only the data extents; holes remain holes after the truncate above
+      off_t offset = 0;
+      while(result && offset < data.st_size) {
+        off_t start = lseek(rd, offset, SEEK_DATA);
+        if(start < 0 && errno == ENXIO) break;  //no data remains
+        off_t end = start < 0 ? -1 : lseek(rd, start, SEEK_HOLE);
+        if(end < 0) start = offset, end = data.st_size;  //holes cannot be detected
+        result = copyExtent(rd, wr, start, end - start, used);
+        offset = end;
+      }
+    }
+
+    ::close(rd);
+    if(::close(wr) != 0) result = false;
+    return result;
+    #else
     file rd, wr;
     if(rd.open(sourcename, mode::read) == false) return false;
     if(wr.open(targetname, mode::write) == false) return false;
-    for(uint n = 0; n < rd.size(); n++) wr.write(rd.read());
+    uint8_t chunk[1 << 16];
+    for(uint64_t offset = 0; offset < rd.size(); offset += sizeof(chunk)) {
+      uint length = min(sizeof(chunk), rd.size() - offset);
+      rd.read(chunk, length);
+      wr.write(chunk, length);
+    }
+    used = method::buffer;
     return true;
+    #endif
   }
 
   //attempt to rename file first
@@ -98,12 +151,46 @@ struct file : inode, varint {
     return write(filename, buffer.data(), buffer.size());
   }
 
-  static auto write(const string& filename, const uint8_t* data, uint size) -> bool {
+  static auto write(const string& filename, const uint8_t* data, uint64_t size) -> bool {
     file fp;
     if(fp.open(filename, mode::write) == false) return false;
+    for(; size > 1u << 30; data += 1u << 30, size -= 1u << 30) fp.write(data, 1u << 30);
     fp.write(data, size);
-    fp.close();
-    return true;
+    return fp.close();
+  }
+
+  //makes targetname another name for sourcename's contents, without copying them
+  //fails across file systems, and on file systems without hard links
+  static auto link(const string& sourcename, const string& targetname) -> bool {
+    #if defined(API_POSIX)
+    return ::link(sourcename, targetname) == 0;
+    #elif defined(API_WINDOWS)
+    return CreateHardLinkW(utf16_t(targetname), utf16_t(sourcename), nullptr);
+    #endif
+  }
+
+  //writes a file's contents (or a folder's entries) through to the storage device
+  //without wait, writeback is only started where possible: syncing many files is quickest as one
+  //pass without wait that starts writing all of them, then a second pass that waits on each
+  static auto sync(const string& filename, bool wait = true) -> bool {
+    #if defined(API_POSIX)
+    int fd = ::open(filename, O_RDONLY);
+    if(fd < 0) return false;
+    #if defined(PLATFORM_LINUX)
+    bool result = wait ? fsync(fd) == 0 : sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE) == 0;
+    #else
+    bool result = !wait || fsync(fd) == 0;
+    #endif
+    ::close(fd);
+    return result;
+    #elif defined(API_WINDOWS)
+    if(!wait || filename.endsWith("/")) return true;  //folders cannot be flushed
+    auto handle = CreateFileW(utf16_t(filename), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+    if(handle == INVALID_HANDLE_VALUE) return false;
+    bool result = FlushFileBuffers(handle);
+    CloseHandle(handle);
+    return result;
+    #endif
   }
 
   static auto create(const string& filename) -> bool {
@@ -114,6 +201,19 @@ struct file : inode, varint {
     return true;
   }
 
+  //create an empty file, failing if it already exists, so that only one caller can claim a name
+  static auto reserve(const string& filename) -> bool {
+    #if defined(API_POSIX)
+    int fd = ::open(filename, O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if(fd < 0) return false;
+    return ::close(fd), true;
+    #elif defined(API_WINDOWS)
+    int fd = _wopen(utf16_t(filename), _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE);
+    if(fd < 0) return false;
+    return _close(fd), true;
+    #endif
+  }
+
   static auto sha256(const string& filename) -> string {
     auto buffer = read(filename);
     return Hash::SHA256(buffer.data(), buffer.size()).digest();
@@ -147,12 +247,34 @@ struct file : inode, varint {
   auto reads(uint length) -> string {
     string result;
     result.resize(length);
-    for(auto& byte : result) byte = read();
+    read((uint8_t*)result.get(), length);
     return result;
   }
 
-  auto read(uint8_t* buffer, uint length) -> void {
-    while(length--) *buffer++ = read();
+  //bytes that cannot be read are filled with 0xff, as with read()
+  auto read(uint8_t* data, uint length) -> void {
+    uint available = 0;
+    if(fp && file_mode != mode::write && file_offset < file_size) available = min(length, file_size - file_offset);
+    memory::fill(data + available, length - available, 0xff);
+    length = available;
+
+    while(length) {
+      if(buffer_offset != (file_offset & ~buffer_mask) && length >= buffer_size) {
+        //large transfers bypass the buffer; a dirty buffer must reach the file first
+        buffer_flush();
+        file_seek(file_offset);
+        auto unused = fread(data, 1, length, fp);
+        file_offset += length;
+        return;
+      }
+      buffer_sync();
+      uint offset = file_offset & buffer_mask;
+      uint count = min(length, buffer_size - offset);
+      memory::copy(data, buffer + offset, count);
+      data += count;
+      file_offset += count;
+      length -= count;
+    }
   }
 
   auto write(uint8_t data) -> void {
@@ -178,17 +300,39 @@ struct file : inode, varint {
   }
 
   auto writes(const string& s) -> void {
-    for(auto byte : s) write(byte);
+    write((const uint8_t*)s.data(), s.size());
   }
 
-  auto write(const uint8_t* buffer, uint length) -> void {
-    while(length--) write(*buffer++);
+  auto write(const uint8_t* data, uint length) -> void {
+    if(!fp) return;                      //file not open
+    if(file_mode == mode::read) return;  //writes not permitted
+
+    while(length) {
+      if(buffer_offset != (file_offset & ~buffer_mask) && length >= buffer_size) {
+        //large transfers bypass the buffer; it is invalidated as it may overlap the written range
+        buffer_flush();
+        buffer_offset = -1;
+        file_seek(file_offset);
+        if(fwrite(data, 1, length, fp) != length) file_failed = true;
+        file_offset += length;
+        if(file_offset > file_size) file_size = file_offset;
+        return;
+      }
+      buffer_sync();
+      uint offset = file_offset & buffer_mask;
+      uint count = min(length, buffer_size - offset);
+      memory::copy(buffer + offset, data, count);
+      buffer_dirty = true;
+      data += count;
+      file_offset += count;
+      length -= count;
+      if(file_offset > file_size) file_size = file_offset;
+    }
   }
 
   template<typename... Args> auto print(Args... args) -> void {
     string data(args...);
-    const char* p = data;
-    while(*p) write(*p++);
+    write((const uint8_t*)data.data(), data.size());
   }
 
   auto flush() -> void {
@@ -196,7 +340,7 @@ struct file : inode, varint {
     fflush(fp);
   }
 
-  auto seek(int offset, index index_ = index::absolute) -> void {
+  auto seek(int64_t offset, index index_ = index::absolute) -> void {
     if(!fp) return;  //file not open
     buffer_flush();
 
@@ -212,29 +356,54 @@ struct file : inode, varint {
         req_offset = file_size;
       } else {                          //pad file to requested location
         file_offset = file_size;
-        while(file_size < req_offset) write(0x00);
+        uint8_t zero[1 << 12] = {0};
+        while(file_size < req_offset) write(zero, min(sizeof(zero), req_offset - file_size));
       }
     }
 
     file_offset = req_offset;
   }
 
-  auto offset() const -> uint {
+  auto offset() const -> uint64_t {
     if(!fp) return 0;  //file not open
     return file_offset;
   }
 
-  auto size() const -> uint {
+  auto size() const -> uint64_t {
     if(!fp) return 0;  //file not open
     return file_size;
   }
 
-  auto truncate(uint size) -> bool {
+  //size is rounded up to a power of two; larger buffers reduce system calls for sequential access
+  auto setBufferSize(uint size) -> void {
+    uint length = 1;
+    while(length < size) length <<= 1;
+    if(length == buffer_size) return;
+    buffer_flush();
+    buffer_offset = -1;
+    if(buffer != buffer_default) delete[] buffer;
+    buffer = length == sizeof(buffer_default) ? buffer_default : new uint8_t[length];
+    buffer_size = length;
+    buffer_mask = length - 1;
+  }
+
+  auto truncate(uint64_t size) -> bool {
     if(!fp) return false;  //file not open
     #if defined(API_POSIX)
     return ftruncate(fileno(fp), size) == 0;
     #elif defined(API_WINDOWS)
-    return _chsize(fileno(fp), size) == 0;
+    return _chsize_s(fileno(fp), size) == 0;
+    #endif
+  }
+
+  //allocates space for size bytes without changing the file's size, so that a file written
+  //sequentially is laid out contiguously, and running out of space fails here rather than midway
+  auto reserve(uint64_t size) -> bool {
+    if(!fp) return false;  //file not open
+    #if defined(PLATFORM_LINUX)
+    return fallocate(fileno(fp), FALLOC_FL_KEEP_SIZE, 0, size) == 0;
+    #else
+    return false;
     #endif
   }
 
@@ -269,18 +438,22 @@ struct file : inode, varint {
     }
     if(!fp) return false;
     buffer_offset = -1;  //invalidate buffer
+    file_failed = false;
     file_offset = 0;
-    fseek(fp, 0, SEEK_END);
-    file_size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
+    file_seek(0, SEEK_END);
+    file_size = file_tell();
+    file_seek(0);
     return true;
   }
 
-  auto close() -> void {
-    if(!fp) return;
+  //returns false if any write since the file was opened failed (e.g. for lack of space), or if
+  //the data still buffered could not be written when closing
+  auto close() -> bool {
+    if(!fp) return false;
     buffer_flush();
-    fclose(fp);
+    bool result = fclose(fp) == 0 && !file_failed;
     fp = nullptr;
+    return result;
   }
 
   auto operator=(const file&) -> file& = delete;
@@ -293,24 +466,87 @@ struct file : inode, varint {
 
   ~file() {
     close();
+    if(buffer != buffer_default) delete[] buffer;
   }
 
 private:
-  enum { buffer_size = 1 << 12, buffer_mask = buffer_size - 1 };
-  char buffer[buffer_size] = {0};
-  int buffer_offset = -1;  //invalidate buffer
+  #if defined(PLATFORM_LINUX)
+  //tries copy_file_range, then sendfile, then read/write; each falls back once unsupported
+  static auto copyExtent(int rd, int wr, off_t offset, off_t length, method& used) -> bool {
+    auto unsupported = [] {
+      return errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP;
+    };
+    auto use = [&](method current) {
+      if((uint)current > (uint)used) used = current;
+    };
+
+    method current = method::range;
+    while(length > 0) {
+      if(current == method::range) {
+        loff_t source = offset, target = offset;
+        ssize_t count = copy_file_range(rd, &source, wr, &target, length, 0);
+        if(count > 0) { use(current); offset += count; length -= count; continue; }
+        if(count == 0 || !unsupported()) return false;
+        current = method::sendfile;
+      } else if(current == method::sendfile) {
+        if(lseek(wr, offset, SEEK_SET) < 0) return false;
+        off_t source = offset;
+        ssize_t count = sendfile(wr, rd, &source, length);
+        if(count > 0) { use(current); offset += count; length -= count; continue; }
+        if(count == 0 || !unsupported()) return false;
+        current = method::buffer;
+      } else {
+        uint8_t chunk[1 << 16];
+        ssize_t count = pread(rd, chunk, min((off_t)sizeof(chunk), length), offset);
+        if(count <= 0) return false;
+        for(ssize_t written = 0; written < count;) {
+          ssize_t result = pwrite(wr, chunk + written, count - written, offset + written);
+          if(result <= 0) return false;
+          written += result;
+        }
+        use(current);
+        offset += count;
+        length -= count;
+      }
+    }
+    return true;
+  }
+  #endif
+
+  uint8_t buffer_default[1 << 12];
+  uint8_t* buffer = buffer_default;
+  uint buffer_size = sizeof(buffer_default);
+  uint64_t buffer_mask = buffer_size - 1;
+  int64_t buffer_offset = -1;  //invalidate buffer
   bool buffer_dirty = false;
   FILE* fp = nullptr;
-  uint file_offset = 0;
-  uint file_size = 0;
+  uint64_t file_offset = 0;
+  uint64_t file_size = 0;
   mode file_mode = mode::read;
+  bool file_failed = false;  //a write was not completed
+
+  auto file_seek(int64_t offset, int origin = SEEK_SET) -> void {
+    #if defined(API_POSIX)
+    fseeko(fp, offset, origin);
+    #elif defined(API_WINDOWS)
+    _fseeki64(fp, offset, origin);
+    #endif
+  }
+
+  auto file_tell() -> uint64_t {
+    #if defined(API_POSIX)
+    return ftello(fp);
+    #elif defined(API_WINDOWS)
+    return _ftelli64(fp);
+    #endif
+  }
 
   auto buffer_sync() -> void {
     if(!fp) return;  //file not open
     if(buffer_offset != (file_offset & ~buffer_mask)) {
       buffer_flush();
       buffer_offset = file_offset & ~buffer_mask;
-      fseek(fp, buffer_offset, SEEK_SET);
+      file_seek(buffer_offset);
       uint length = (buffer_offset + buffer_size) <= file_size ? buffer_size : (file_size & buffer_mask);
       if(length) auto unused = fread(buffer, 1, length, fp);
     }
@@ -321,9 +557,9 @@ private:
     if(file_mode == mode::read) return;  //buffer cannot be written to
     if(buffer_offset < 0) return;        //buffer unused
     if(buffer_dirty == false) return;    //buffer unmodified since read
-    fseek(fp, buffer_offset, SEEK_SET);
+    file_seek(buffer_offset);
     uint length = (buffer_offset + buffer_size) <= file_size ? buffer_size : (file_size & buffer_mask);
-    if(length) auto unused = fwrite(buffer, 1, length, fp);
+    if(length && fwrite(buffer, 1, length, fp) != length) file_failed = true;
     buffer_offset = -1;                  //invalidate buffer
     buffer_dirty = false;
   }
@@ -29,13 +29,13 @@ struct filemap {
   auto open() const -> bool { return p_open(); }
   auto open(const string& filename, mode mode_) -> bool { return p_open(filename, mode_); }
   auto close() -> void { return p_close(); }
-  auto size() const -> unsigned { return p_size; }
+  auto size() const -> uint64_t { return p_size; }
   auto data() -> uint8_t* { return p_handle; }
   auto data() const -> const uint8_t* { return p_handle; }
 
 private:
   uint8_t* p_handle = nullptr;
-  unsigned p_size = 0;
+  uint64_t p_size = 0;
 
   #if defined(API_WINDOWS)
   //=============
@@ -91,9 +91,11 @@ private:
       creation_disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
     if(p_filehandle == INVALID_HANDLE_VALUE) return false;
 
-    p_size = GetFileSize(p_filehandle, nullptr);
+    LARGE_INTEGER size;
+    GetFileSizeEx(p_filehandle, &size);
+    p_size = size.QuadPart;
 
-    p_maphandle = CreateFileMapping(p_filehandle, nullptr, flprotect, 0, p_size, nullptr);
+    p_maphandle = CreateFileMapping(p_filehandle, nullptr, flprotect, p_size >> 32, (DWORD)p_size, nullptr);
     if(p_maphandle == INVALID_HANDLE_VALUE) {
       CloseHandle(p_filehandle);
       p_filehandle = INVALID_HANDLE_VALUE;
@@ -12,7 +12,32 @@ struct CRC32 : Hash {
   }
 
   auto input(uint8_t value) -> void override {
-    checksum = (checksum >> 8) ^ table(checksum ^ value);
+    checksum = (checksum >> 8) ^ tables().slice[0][(uint8_t)(checksum ^ value)];
+  }
+
+  //slicing-by-8: consumes eight bytes per step through eight derived tables
+  auto input(const void* data, uint64_t size) -> void {
+    auto p = (const uint8_t*)data;
+    auto& t = tables().slice;
+    uint32_t crc = checksum;
+    while(size >= 8) {
+      uint32_t lo = crc ^ (p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24);
+      uint32_t hi = p[4] | p[5] << 8 | p[6] << 16 | (uint32_t)p[7] << 24;
+      crc = t[7][lo & 0xff] ^ t[6][lo >> 8 & 0xff] ^ t[5][lo >> 16 & 0xff] ^ t[4][lo >> 24]
+          ^ t[3][hi & 0xff] ^ t[2][hi >> 8 & 0xff] ^ t[1][hi >> 16 & 0xff] ^ t[0][hi >> 24];
+      p += 8;
+      size -= 8;
+    }
+    while(size--) crc = (crc >> 8) ^ t[0][(uint8_t)(crc ^ *p++)];
+    checksum = crc;
+  }
+
+  auto input(const vector<uint8_t>& data) -> void {
+    input(data.data(), data.size());
+  }
+
+  auto input(const string& data) -> void {
+    input(data.data(), data.size());
   }
 
   auto output() const -> vector<uint8_t> {
@@ -26,22 +51,28 @@ struct CRC32 : Hash {
   }
 
 private:
-  static auto table(uint8_t index) -> uint32_t {
-    static uint32_t table[256] = {0};
-    static bool initialized = false;
-
-    if(!initialized) {
-      initialized = true;
+  struct Tables {
+    Tables() {
       for(auto index : range(256)) {
         uint32_t crc = index;
         for(auto bit : range(8)) {
           crc = (crc >> 1) ^ (crc & 1 ? 0xedb8'8320 : 0);
         }
-        table[index] = crc;
+        slice[0][index] = crc;
+      }
+      for(auto index : range(256)) {
+        for(auto n : range(1, 8)) {
+          slice[n][index] = (slice[n - 1][index] >> 8) ^ slice[0][slice[n - 1][index] & 0xff];
+        }
       }
     }
 
-    return table[index];
+    uint32_t slice[8][256];
+  };
+
+  static auto tables() -> const Tables& {
+    static const Tables instance;
+    return instance;
   }
 
   uint32_t checksum = 0;
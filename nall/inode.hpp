@@ -6,6 +6,10 @@
 #include <nall/platform.hpp>
 #include <nall/string.hpp>
 
+#if defined(PLATFORM_LINUX)
+  #include <sys/syscall.h>
+#endif
+
 namespace nall {
 
 struct inode {
@@ -54,6 +58,15 @@ struct inode {
     }
   }
 
+  //sets the access and modification times of an existing file or directory to now
+  static auto touch(const string& name) -> bool {
+    #if defined(PLATFORM_WINDOWS)
+    return _wutime(utf16_t(name), nullptr) == 0;
+    #else
+    return utime(name, nullptr) == 0;
+    #endif
+  }
+
   //returns true if 'name' already exists
   static auto create(const string& name, uint permissions = 0755) -> bool {
     if(exists(name)) return true;
@@ -68,6 +81,17 @@ struct inode {
     return ::rename(name, targetname) == 0;
   }
 
+  //atomically swaps two existing files or folders, which rename() cannot replace a non-empty folder with
+  //returns false where this is not supported (other platforms, older kernels and some file systems)
+  static auto exchange(const string& name, const string& targetname) -> bool {
+    #if defined(PLATFORM_LINUX) && defined(SYS_renameat2)
+    enum : uint { RenameExchange = 1 << 1 };  //RENAME_EXCHANGE, which older C libraries do not define
+    return syscall(SYS_renameat2, AT_FDCWD, (const char*)name, AT_FDCWD, (const char*)targetname, RenameExchange) == 0;
+    #else
+    return false;
+    #endif
+  }
+
   //returns false if 'name' is a directory that is not empty
   static auto remove(const string& name) -> bool {
     #if defined(PLATFORM_WINDOWS)
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <string.h>
 #include <nall/algorithm.hpp>
 #include <nall/stdint.hpp>
 
 namespace nall { namespace memory {
+  //spans of at least this many bytes are handed to the C library (see implementation notes)
+  enum : uint { LibraryThreshold = 16 };
+
   inline auto allocate(uint size) -> void*;
   inline auto allocate(uint size, uint8_t data) -> void*;
 
@@ -33,6 +37,45 @@ namespace nall { namespace memory {
 
   template<uint size, typename T = uint64_t> inline auto writel(void* target, T data) -> void;
   template<uint size, typename T = uint64_t> inline auto writem(void* target, T data) -> void;
+
+  //allocations may be served by another allocator (e.g. nall::arena) while a scope on it is active
+  //allocators register themselves on construction, so that memory they own is freed by them even
+  //once their scope has ended; allocators and scopes belong to the thread that created them
+  struct allocator {
+    inline allocator();
+    inline virtual ~allocator();
+    virtual auto allocate(uint size) -> void* = 0;
+    virtual auto resize(void* target, uint size) -> void* = 0;  //target is owned by this allocator
+    virtual auto free(void* target) -> void = 0;                //target is owned by this allocator
+    virtual auto owns(const void* target) const -> bool = 0;
+
+    allocator* next;  //registered before this one, on the same thread
+  };
+
+  //redirects this thread's allocations for its lifetime; scopes nest
+  //a scope on nullptr restores the C library heap, e.g. for results that must outlive an arena
+  struct scope {
+    scope(allocator* target) : previous(scoped()) { scoped() = target; }
+    ~scope() { scoped() = previous; }
+    scope(const scope&) = delete;
+    auto operator=(const scope&) -> scope& = delete;
+
+    static auto scoped() -> allocator*& { static thread_local allocator* target = nullptr; return target; }
+
+  private:
+    allocator* previous;
+  };
+
+  inline auto allocators() -> allocator*& { static thread_local allocator* first = nullptr; return first; }
+  inline auto owner(const void* target) -> allocator*;
+
+  //define NALL_MEMORY_STATISTICS to count the calls that reach the C library heap, per thread
+  struct Statistics {
+    uint64_t allocations = 0;
+    uint64_t resizes = 0;
+    uint64_t frees = 0;
+  };
+  inline auto statistics() -> Statistics& { static thread_local Statistics counts; return counts; }
 }}
 
 namespace nall {
@@ -41,22 +84,56 @@ namespace nall {
 //memcmp, memcpy, memmove have terrible performance on small block sizes (FreeBSD 10.0-amd64)
 //as this library is used extensively by nall/string, and most strings tend to be small,
 //this library hand-codes these functions instead. surprisingly, it's a substantial speedup
+//the same functions also copy, fill and compare entire ROMs, where the byte loops run an order of
+//magnitude behind the vectorized C library routines; so only spans shorter than LibraryThreshold
+//bytes take the hand-coded path
+
+memory::allocator::allocator() : next(allocators()) {
+  allocators() = this;
+}
+
+memory::allocator::~allocator() {
+  for(auto link = &allocators(); *link; link = &(*link)->next) {
+    if(*link == this) { *link = next; break; }
+  }
+}
+
+auto memory::owner(const void* target) -> allocator* {
+  for(auto instance = allocators(); instance; instance = instance->next) {
+    if(instance->owns(target)) return instance;
+  }
+  return nullptr;
+}
 
 auto memory::allocate(uint size) -> void* {
+  if(auto target = scope::scoped()) return target->allocate(size);
+  #if defined(NALL_MEMORY_STATISTICS)
+  statistics().allocations++;
+  #endif
   return malloc(size);
 }
 
 auto memory::allocate(uint size, uint8_t data) -> void* {
-  auto result = malloc(size);
+  auto result = allocate(size);
   if(result) fill(result, size, data);
   return result;
 }
 
 auto memory::resize(void* target, uint size) -> void* {
+  if(!target) return allocate(size);
+  if(auto instance = owner(target)) return instance->resize(target, size);
+  #if defined(NALL_MEMORY_STATISTICS)
+  statistics().resizes++;
+  #endif
   return realloc(target, size);
 }
 
 auto memory::free(void* target) -> void {
+  if(!target) return;
+  if(auto instance = owner(target)) return instance->free(target);
+  #if defined(NALL_MEMORY_STATISTICS)
+  statistics().frees++;
+  #endif
   ::free(target);
 }
 
@@ -64,6 +141,16 @@ auto memory::compare(const void* target, uint capacity, const void* source, uint
   auto t = (int8_t*)target;
   auto s = (int8_t*)source;
   auto l = min(capacity, size);
+  //memcmp orders bytes as unsigned, so it is only used to narrow down the first difference:
+  //the span is halved around it until the byte loop can take the signed difference
+  if(l >= LibraryThreshold && !::memcmp(t, s, l)) return 0;
+  while(l >= LibraryThreshold) {
+    uint half = l >> 1;
+    if(::memcmp(t, s, half)) { l = half; continue; }
+    t += half;
+    s += half;
+    l -= half;
+  }
   while(l--) {
     auto x = *t++;
     auto y = *s++;
@@ -98,6 +185,7 @@ auto memory::copy(void* target, uint capacity, const void* source, uint size) ->
   auto t = (uint8_t*)target;
   auto s = (uint8_t*)source;
   auto l = min(capacity, size);
+  if(l >= LibraryThreshold) return ::memcpy(target, source, l), target;
   while(l--) *t++ = *s++;
   return target;
 }
@@ -110,6 +198,7 @@ auto memory::move(void* target, uint capacity, const void* source, uint size) ->
   auto t = (uint8_t*)target;
   auto s = (uint8_t*)source;
   auto l = min(capacity, size);
+  if(l >= LibraryThreshold) return ::memmove(target, source, l), target;
   if(t < s) {
     while(l--) *t++ = *s++;
   } else {
@@ -126,6 +215,7 @@ auto memory::move(void* target, const void* source, uint size) -> void* {
 
 auto memory::fill(void* target, uint capacity, uint8_t data) -> void* {
   auto t = (uint8_t*)target;
+  if(capacity >= LibraryThreshold) return ::memset(target, data, capacity), target;
   while(capacity--) *t++ = data;
   return target;
 }
@@ -15,6 +15,7 @@
 
 #include <nall/algorithm.hpp>
 #include <nall/any.hpp>
+#include <nall/arena.hpp>
 #include <nall/arithmetic.hpp>
 #include <nall/array.hpp>
 #include <nall/atoi.hpp>
@@ -45,6 +46,7 @@
 #include <nall/queue.hpp>
 #include <nall/random.hpp>
 #include <nall/range.hpp>
+#include <nall/reference-count.hpp>
 #include <nall/run.hpp>
 #include <nall/serializer.hpp>
 #include <nall/set.hpp>
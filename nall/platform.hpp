@@ -38,6 +38,7 @@ namespace Math {
 #if defined(PLATFORM_WINDOWS)
   #include <io.h>
   #include <direct.h>
+  #include <sys/utime.h>
   #include <shlobj.h>
   #include <wchar.h>
   #include <winsock2.h>
@@ -45,6 +46,7 @@ namespace Math {
 #else
   #include <dlfcn.h>
   #include <unistd.h>
+  #include <utime.h>
   #include <pwd.h>
   #include <grp.h>
   #include <sys/socket.h>
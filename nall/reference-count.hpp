@@ -0,0 +1,55 @@
+#pragma once
+
+//reference counts shared by shared_pointer and the copy-on-write string allocators
+//plain counters by default; define NALL_ATOMIC_REFERENCE_COUNTS (in every translation unit of a
+//program, e.g. with -D) to make them atomic, so that strings, Markup::Node trees and other
+//shared_pointer-based objects may be copied and released from several threads at once
+//this only makes sharing safe: modifying one object from several threads still needs a lock
+
+#include <nall/stdint.hpp>
+
+#if defined(NALL_ATOMIC_REFERENCE_COUNTS)
+  #include <atomic>
+#endif
+
+namespace nall {
+
+struct reference_count {
+  reference_count(uint count = 0) : count(count) {}
+  reference_count(const reference_count&) = delete;
+  auto operator=(const reference_count&) -> reference_count& = delete;
+
+  #if defined(NALL_ATOMIC_REFERENCE_COUNTS)
+  //acquiring a reference needs no ordering: it is made from one the caller already holds
+  auto increment() -> void { count.fetch_add(1, std::memory_order_relaxed); }
+
+  //returns true when the last reference was released; acq_rel orders every holder's accesses
+  //before whatever the releaser of the last reference does next (usually freeing the object)
+  auto decrement() -> bool { return count.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+
+  //for weak references: only acquires if the object is still alive
+  auto incrementIfNonzero() -> bool {
+    uint value = count.load(std::memory_order_relaxed);
+    while(value) {
+      if(count.compare_exchange_weak(value, value + 1, std::memory_order_relaxed)) return true;
+    }
+    return false;
+  }
+
+  operator uint() const { return count.load(std::memory_order_acquire); }
+
+private:
+  std::atomic<uint> count;
+  #else
+  auto increment() -> void { count++; }
+  auto decrement() -> bool { return --count == 0; }
+  auto incrementIfNonzero() -> bool { return count ? count++, true : false; }
+
+  operator uint() const { return count; }
+
+private:
+  uint count;
+  #endif
+};
+
+}
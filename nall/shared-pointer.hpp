@@ -2,6 +2,7 @@
 
 #include <nall/function.hpp>
 #include <nall/maybe.hpp>
+#include <nall/reference-count.hpp>
 #include <nall/traits.hpp>
 #include <nall/vector.hpp>
 
@@ -9,11 +10,13 @@ namespace nall {
 
 template<typename T> struct shared_pointer;
 
+//weak counts the weak references, plus one held by all strong references together:
+//the manager is deleted when weak reaches zero, which is never while the object is alive
 struct shared_pointer_manager {
   void* pointer = nullptr;
   function<auto (void*) -> void> deleter;
-  uint strong = 0;
-  uint weak = 0;
+  reference_count strong{1};
+  reference_count weak{1};
 
   shared_pointer_manager(void* pointer) : pointer(pointer) {
   }
@@ -71,7 +74,7 @@ struct shared_pointer {
   shared_pointer(const shared_pointer<U>& source, T* pointer) {
     if((bool)source && (T*)source.manager->pointer == pointer) {
       manager = source.manager;
-      manager->strong++;
+      manager->strong.increment();
     }
   }
 
@@ -83,7 +86,6 @@ struct shared_pointer {
     reset();
     if(source) {
       manager = new shared_pointer_manager((void*)source);
-      manager->strong++;
     }
     return *this;
   }
@@ -93,7 +95,7 @@ struct shared_pointer {
       reset();
       if((bool)source) {
         manager = source.manager;
-        manager->strong++;
+        manager->strong.increment();
       }
     }
     return *this;
@@ -114,7 +116,7 @@ struct shared_pointer {
       reset();
       if((bool)source) {
         manager = source.manager;
-        manager->strong++;
+        manager->strong.increment();
       }
     }
     return *this;
@@ -133,9 +135,8 @@ struct shared_pointer {
   template<typename U, typename = enable_if_t<is_compatible<U>::value>>
   auto operator=(const shared_pointer_weak<U>& source) -> shared_pointer& {
     reset();
-    if((bool)source) {
+    if(source.manager && source.manager->strong.incrementIfNonzero()) {
       manager = source.manager;
-      manager->strong++;
     }
     return *this;
   }
@@ -178,22 +179,16 @@ struct shared_pointer {
   }
 
   auto reset() -> void {
-    if(manager && manager->strong) {
-      //pointer may contain weak references; if strong==0 it may destroy manager
-      //as such, we must destroy strong before decrementing it to zero
-      if(manager->strong == 1) {
-        if(manager->deleter) {
-          manager->deleter(manager->pointer);
-        } else {
-          delete (T*)manager->pointer;
-        }
-        manager->pointer = nullptr;
-      }
-      if(--manager->strong == 0) {
-        if(manager->weak == 0) {
-          delete manager;
-        }
+    if(manager && manager->strong.decrement()) {
+      //pointer may contain weak references to itself; the strong references' share of weak
+      //keeps manager alive while they are released, so it is only given up afterward
+      if(manager->deleter) {
+        manager->deleter(manager->pointer);
+      } else {
+        delete (T*)manager->pointer;
       }
+      manager->pointer = nullptr;
+      if(manager->weak.decrement()) delete manager;
     }
     manager = nullptr;
   }
@@ -221,7 +216,7 @@ struct shared_pointer_weak {
 
   auto operator=(const shared_pointer<T>& source) -> shared_pointer_weak& {
     reset();
-    if(manager = source.manager) manager->weak++;
+    if(manager = source.manager) manager->weak.increment();
     return *this;
   }
 
@@ -246,11 +241,7 @@ struct shared_pointer_weak {
   }
 
   auto reset() -> void {
-    if(manager && --manager->weak == 0) {
-      if(manager->strong == 0) {
-        delete manager;
-      }
-    }
+    if(manager && manager->weak.decrement()) delete manager;
     manager = nullptr;
   }
 };
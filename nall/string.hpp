@@ -5,6 +5,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+
 #include <algorithm>
 #include <initializer_list>
 #include <memory>
@@ -15,6 +19,7 @@
 #include <nall/intrinsics.hpp>
 #include <nall/memory.hpp>
 #include <nall/primitives.hpp>
+#include <nall/reference-count.hpp>
 #include <nall/shared-pointer.hpp>
 #include <nall/stdint.hpp>
 #include <nall/utility.hpp>
@@ -88,7 +93,7 @@ protected:
   union {
     struct {  //copy-on-write
       char* _data;
-      uint* _refs;
+      reference_count* _refs;
     };
     struct {  //small-string-optimization
       char _text[SSO];
@@ -101,7 +106,7 @@ protected:
 
   #if defined(NALL_STRING_ALLOCATOR_COPY_ON_WRITE)
   char* _data;
-  mutable uint* _refs;
+  mutable reference_count* _refs;
   inline auto _allocate() -> char*;
   inline auto _copy() -> char*;
   #endif
@@ -201,6 +206,9 @@ public:
   //format.hpp
   inline auto format(const nall::string_format& params) -> type&;
 
+  //find.hpp
+  inline static auto _search(const char*, uint, const char*, uint) -> const char*;
+
   //compare.hpp
   template<bool> inline static auto _compare(const char*, uint, const char*, uint) -> int;
 
@@ -299,6 +307,31 @@ struct string_vector : vector<string> {
   template<bool, bool> inline auto _split(string_view, string_view, long) -> type&;
 };
 
+//a wildcard pattern ('*' and '?', as in string::match), classified once so that it can be
+//matched against many names: literals, prefixes, suffixes and substrings need a single compare
+struct string_pattern {
+  using type = string_pattern;
+
+  //pattern.hpp
+  inline string_pattern(string_view pattern = "", bool insensitive = false);
+
+  inline auto literal() const -> bool;
+  inline auto match(string_view name) const -> bool;
+  inline auto filter(const string_vector& list) const -> string_vector;
+
+private:
+  enum class Kind : uint { Literal, Prefix, Suffix, Substring, Any, General };
+  struct Segment { uint offset, length; bool wildcard; };
+
+  inline auto compare(const char* name, const Segment& segment) const -> bool;
+  inline auto search(const char* name, uint size, const Segment& segment) const -> const char*;
+
+  string _pattern;
+  bool _insensitive = false;
+  Kind _kind = Kind::Literal;
+  vector<Segment> _segments;  //the text between each '*'
+};
+
 struct string_format : vector<string> {
   using type = string_format;
 
@@ -319,6 +352,7 @@ struct string_format : vector<string> {
 #include <nall/string/format.hpp>
 #include <nall/string/list.hpp>
 #include <nall/string/match.hpp>
+#include <nall/string/pattern.hpp>
 #include <nall/string/replace.hpp>
 #include <nall/string/split.hpp>
 #include <nall/string/trim.hpp>
@@ -36,7 +36,7 @@ auto string::data() const -> const T* {
 }
 
 auto string::reset() -> type& {
-  if(_capacity >= SSO && !--*_refs) memory::free(_data);
+  if(_capacity >= SSO && _refs->decrement()) memory::free(_data);
   _data = nullptr;
   _capacity = SSO - 1;
   _size = 0;
@@ -73,7 +73,7 @@ auto string::operator=(const string& source) -> type& {
     _refs = source._refs;
     _capacity = source._capacity;
     _size = source._size;
-    ++*_refs;
+    _refs->increment();
   } else {
     memory::copy(_text, source._text, SSO);
     _capacity = source._capacity;
@@ -96,28 +96,26 @@ auto string::operator=(string&& source) -> type& {
 auto string::_allocate() -> void {
   char _temp[SSO];
   memory::copy(_temp, _text, SSO);
-  _data = (char*)memory::allocate(_capacity + 1 + sizeof(uint));
+  _data = (char*)memory::allocate(_capacity + 1 + sizeof(reference_count));
   memory::copy(_data, _temp, SSO);
-  _refs = (uint*)(_data + _capacity + 1);  //always aligned by 32 via reserve()
-  *_refs = 1;
+  _refs = new(_data + _capacity + 1) reference_count{1};  //always aligned by 32 via reserve()
 }
 
 //COW -> Unique
+//with atomic reference counts, the other owners may have let go in the meantime
 auto string::_copy() -> void {
-  auto _temp = (char*)memory::allocate(_capacity + 1 + sizeof(uint));
+  auto _temp = (char*)memory::allocate(_capacity + 1 + sizeof(reference_count));
   memory::copy(_temp, _data, _size = min(_capacity, _size));
   _temp[_size] = 0;
-  --*_refs;
+  if(_refs->decrement()) memory::free(_data);
   _data = _temp;
-  _refs = (uint*)(_data + _capacity + 1);
-  *_refs = 1;
+  _refs = new(_data + _capacity + 1) reference_count{1};
 }
 
 //COW -> Resize
 auto string::_resize() -> void {
-  _data = (char*)memory::resize(_data, _capacity + 1 + sizeof(uint));
-  _refs = (uint*)(_data + _capacity + 1);
-  *_refs = 1;
+  _data = (char*)memory::resize(_data, _capacity + 1 + sizeof(reference_count));
+  _refs = new(_data + _capacity + 1) reference_count{1};
 }
 
 }
@@ -19,7 +19,7 @@ auto string::data() const -> const char* {
 }
 
 auto string::reset() -> type& {
-  if(_data && !--*_refs) {
+  if(_data && _refs->decrement()) {
     memory::free(_data);
     _data = nullptr;  //_refs = nullptr; is unnecessary
   }
@@ -50,7 +50,7 @@ auto string::operator=(const string& source) -> string& {
     _refs = source._refs;
     _capacity = source._capacity;
     _size = source._size;
-    ++*_refs;
+    _refs->increment();
   }
   return *this;
 }
@@ -70,20 +70,18 @@ auto string::operator=(string&& source) -> string& {
 }
 
 auto string::_allocate() -> char* {
-  auto _temp = (char*)memory::allocate(_capacity + 1 + sizeof(uint));
+  auto _temp = (char*)memory::allocate(_capacity + 1 + sizeof(reference_count));
   *_temp = 0;
-  _refs = (uint*)(_temp + _capacity + 1);  //this will always be aligned by 32 via reserve()
-  *_refs = 1;
+  _refs = new(_temp + _capacity + 1) reference_count{1};  //this will always be aligned by 32 via reserve()
   return _temp;
 }
 
 auto string::_copy() -> char* {
-  auto _temp = (char*)memory::allocate(_capacity + 1 + sizeof(uint));
+  auto _temp = (char*)memory::allocate(_capacity + 1 + sizeof(reference_count));
   memory::copy(_temp, _data, _size = min(_capacity, _size));
   _temp[_size] = 0;
-  --*_refs;
-  _refs = (uint*)(_temp + _capacity + 1);
-  *_refs = 1;
+  if(_refs->decrement()) memory::free(_data);
+  _refs = new(_temp + _capacity + 1) reference_count{1};
   return _temp;
 }
 
@@ -2,11 +2,49 @@
 
 namespace nall {
 
+//case-sensitive search for the first occurrence of needle within data
+//candidates are positions whose first and last bytes both match: sixteen positions are tested at
+//a time with SSE2, or memchr finds the next first byte otherwise; only candidates are compared
+auto string::_search(const char* data, uint size, const char* needle, uint length) -> const char* {
+  if(length == 0 || length > size) return nullptr;
+  if(length == 1) return (const char*)memchr(data, needle[0], size);
+  const char* last = data + size - length;  //the last position a match can start at
+
+  #if defined(__SSE2__)
+  __m128i first = _mm_set1_epi8(needle[0]);
+  __m128i final = _mm_set1_epi8(needle[length - 1]);
+  for(; last - data >= 15; data += 16) {
+    __m128i head = _mm_loadu_si128((const __m128i*)data);
+    __m128i tail = _mm_loadu_si128((const __m128i*)(data + length - 1));
+    uint mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, final)));
+    while(mask) {
+      uint bit = __builtin_ctz(mask);
+      if(!memcmp(data + bit + 1, needle + 1, length - 2)) return data + bit;
+      mask &= mask - 1;
+    }
+  }
+  #endif
+
+  while(data <= last) {
+    data = (const char*)memchr(data, needle[0], last - data + 1);
+    if(!data) return nullptr;
+    if(data[length - 1] == needle[length - 1] && !memcmp(data + 1, needle + 1, length - 2)) return data;
+    data++;
+  }
+  return nullptr;
+}
+
 template<bool Insensitive, bool Quoted> auto string::_find(int offset, string_view source) const -> maybe<uint> {
   if(source.size() == 0) return nothing;
 
   auto p = data();
-  for(uint n = offset, quoted = 0; n < size();) {
+  if(!Insensitive && !Quoted) {
+    if((uint)offset >= size()) return nothing;
+    if(auto match = _search(p + offset, size() - offset, source.data(), source.size())) return match - (p + offset);
+    return nothing;
+  }
+
+  for(uint n = offset, quoted = 0; n + source.size() <= size();) {
     if(Quoted) { if(p[n] == '\"') { quoted ^= 1; n++; continue; } if(quoted) { n++; continue; } }
     if(_compare<Insensitive>(p + n, size() - n, source.data(), source.size())) { n++; continue; }
     return n - offset;
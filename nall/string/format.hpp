@@ -45,7 +45,7 @@ auto string::format(const nall::string_format& params) -> type& {
       size -= difference;
     } else if(targetSize > sourceSize) {
       uint difference = targetSize - sourceSize;
-      data = (char*)realloc(data, size + difference);
+      data = (char*)memory::resize(data, size + difference);
       size += difference;
       memory::move(&data[x + difference], &data[x], remaining);
     }
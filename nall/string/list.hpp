@@ -47,11 +47,7 @@ auto string_vector::ifind(string_view source) const -> maybe<uint> {
 }
 
 auto string_vector::match(string_view pattern) const -> type {
-  string_vector result;
-  for(uint n = 0; n < size(); n++) {
-    if(operator[](n).match(pattern)) result.append(operator[](n));
-  }
-  return result;
+  return string_pattern{pattern}.filter(*this);
 }
 
 auto string_vector::merge(string_view separator) const -> string {
@@ -78,8 +78,9 @@ auto ManagedNode::_find(const string& query) const -> vector<Node> {
   }
 
   uint position = 0;
+  string_pattern pattern{name};
   for(auto& node : _children) {
-    if(!node->_name.match(name)) continue;
+    if(!pattern.match(node->_name)) continue;
     if(!node->_evaluate(rule)) continue;
 
     bool inrange = position >= lo && position <= hi;
@@ -0,0 +1,118 @@
+#pragma once
+
+namespace nall {
+
+//the pattern is split at each '*' into segments: the first is anchored to the start of a name, the
+//last to its end, and those in between are searched for left to right
+string_pattern::string_pattern(string_view pattern, bool insensitive) : _pattern(pattern), _insensitive(insensitive) {
+  uint start = 0;
+  bool wildcard = false;
+  for(uint n : range(_pattern.size() + 1)) {
+    if(n < _pattern.size() && _pattern[n] != '*') {
+      wildcard |= _pattern[n] == '?';
+      continue;
+    }
+    _segments.append({start, n - start, wildcard});
+    start = n + 1;
+    wildcard = false;
+  }
+
+  bool general = false;
+  for(auto& segment : _segments) general |= segment.wildcard;
+  auto& first = _segments.left();
+  auto& last = _segments.right();
+  if(general) _kind = Kind::General;
+  else if(_segments.size() == 1) _kind = Kind::Literal;
+  else if(_segments.size() == 2 && !first.length && !last.length) _kind = Kind::Any;
+  else if(_segments.size() == 2 && !first.length) _kind = Kind::Suffix;
+  else if(_segments.size() == 2 && !last.length) _kind = Kind::Prefix;
+  else if(_segments.size() == 3 && !first.length && !last.length && !_insensitive) _kind = Kind::Substring;
+  else _kind = Kind::General;
+}
+
+//true if the pattern has no wildcards, and so matches only itself
+auto string_pattern::literal() const -> bool {
+  return _kind == Kind::Literal;
+}
+
+auto string_pattern::match(string_view name) const -> bool {
+  const char* p = name.data();
+  uint size = name.size();
+
+  switch(_kind) {
+  case Kind::Literal: {
+    return size == _pattern.size() && compare(p, _segments[0]);
+  }
+  case Kind::Prefix: {
+    auto& first = _segments.left();
+    return size >= first.length && compare(p, first);
+  }
+  case Kind::Suffix: {
+    auto& last = _segments.right();
+    return size >= last.length && compare(p + size - last.length, last);
+  }
+  case Kind::Substring: {
+    auto& middle = _segments[1];
+    return !middle.length || string::_search(p, size, _pattern.data() + middle.offset, middle.length);
+  }
+  case Kind::Any: {
+    return true;
+  }
+  case Kind::General: {
+    auto& first = _segments.left();
+    if(size < first.length || !compare(p, first)) return false;
+    if(_segments.size() == 1) return size == first.length;
+    p += first.length, size -= first.length;
+    for(uint n : range(1, _segments.size() - 1)) {
+      auto& middle = _segments[n];
+      auto found = search(p, size, middle);
+      if(!found) return false;
+      size -= found + middle.length - p;
+      p = found + middle.length;
+    }
+    auto& last = _segments.right();
+    return size >= last.length && compare(p + size - last.length, last);
+  }
+  }
+
+  return false;
+}
+
+//returns the names in list that match, in order
+auto string_pattern::filter(const string_vector& list) const -> string_vector {
+  if(_kind == Kind::Any) return list;
+  string_vector result;
+  for(auto& name : list) {
+    if(match(name)) result.append(name);
+  }
+  return result;
+}
+
+//compares a segment against the start of name, which must hold at least segment.length bytes
+auto string_pattern::compare(const char* name, const Segment& segment) const -> bool {
+  const char* text = _pattern.data() + segment.offset;
+  if(!segment.wildcard && !_insensitive) return !memory::compare(name, text, segment.length);
+
+  static auto chrlower = [](char c) -> char {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+  };
+  for(uint c : range(segment.length)) {
+    if(text[c] == '?') continue;
+    if(_insensitive ? chrlower(text[c]) != chrlower(name[c]) : text[c] != name[c]) return false;
+  }
+  return true;
+}
+
+//finds the leftmost occurrence of a segment within name
+auto string_pattern::search(const char* name, uint size, const Segment& segment) const -> const char* {
+  if(!segment.length) return name;
+  if(!segment.wildcard && !_insensitive) {
+    return string::_search(name, size, _pattern.data() + segment.offset, segment.length);
+  }
+  for(; size >= segment.length; name++, size--) {
+    if(compare(name, segment)) return name;
+  }
+  return nullptr;
+}
+
+}
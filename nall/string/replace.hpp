@@ -14,8 +14,14 @@ auto string::_replace(string_view from, string_view to, long limit) -> string& {
   //(recording matches would also require memory allocation, so this is not done)
   { const char* p = data();
     for(int n = 0; n <= size - (int)from.size();) {
-      if(Quoted) { if(p[n] == '\"') { quoted ^= 1; n++; continue; } if(quoted) { n++; continue; } }
-      if(_compare<Insensitive>(p + n, size - n, from.data(), from.size())) { n++; continue; }
+      if(!Insensitive && !Quoted) {
+        auto match = _search(p + n, size - n, from.data(), from.size());
+        if(!match) break;
+        n = match - p;
+      } else {
+        if(Quoted) { if(p[n] == '\"') { quoted ^= 1; n++; continue; } if(quoted) { n++; continue; } }
+        if(_compare<Insensitive>(p + n, size - n, from.data(), from.size())) { n++; continue; }
+      }
 
       if(++matches >= limit) break;
       n += from.size();
@@ -28,8 +34,14 @@ auto string::_replace(string_view from, string_view to, long limit) -> string& {
     char* p = get();
 
     for(int n = 0, remaining = matches, quoted = 0; n <= size - (int)from.size();) {
-      if(Quoted) { if(p[n] == '\"') { quoted ^= 1; n++; continue; } if(quoted) { n++; continue; } }
-      if(_compare<Insensitive>(p + n, size - n, from.data(), from.size())) { n++; continue; }
+      if(!Insensitive && !Quoted) {
+        auto match = _search(p + n, size - n, from.data(), from.size());
+        if(!match) break;
+        n = match - p;
+      } else {
+        if(Quoted) { if(p[n] == '\"') { quoted ^= 1; n++; continue; } if(quoted) { n++; continue; } }
+        if(_compare<Insensitive>(p + n, size - n, from.data(), from.size())) { n++; continue; }
+      }
 
       memory::copy(p + n, to.data(), to.size());
 
@@ -45,10 +57,16 @@ auto string::_replace(string_view from, string_view to, long limit) -> string& {
     int base = 0;
 
     for(int n = 0, remaining = matches, quoted = 0; n <= size - (int)from.size();) {
-      if(Quoted) { if(p[n] == '\"') { quoted ^= 1; n++; continue; } if(quoted) { n++; continue; } }
-      if(_compare<Insensitive>(p + n, size - n, from.data(), from.size())) { n++; continue; }
-
-      if(offset) memory::move(p + offset, p + base, n - base);
+      if(!Insensitive && !Quoted) {
+        auto match = _search(p + n, size - n, from.data(), from.size());
+        if(!match) break;
+        n = match - p;
+      } else {
+        if(Quoted) { if(p[n] == '\"') { quoted ^= 1; n++; continue; } if(quoted) { n++; continue; } }
+        if(_compare<Insensitive>(p + n, size - n, from.data(), from.size())) { n++; continue; }
+      }
+
+      if(offset != base) memory::move(p + offset, p + base, n - base);
       memory::copy(p + offset + (n - base), to.data(), to.size());
       offset += (n - base) + to.size();
 
@@ -61,6 +79,27 @@ auto string::_replace(string_view from, string_view to, long limit) -> string& {
     resize(size - matches * (from.size() - to.size()));
   }
 
+  //left-to-right expand into a new buffer, when matches can be searched for directly
+  else if(!Insensitive && !Quoted) {
+    string result;
+    result.resize(size + matches * (to.size() - from.size()));
+    const char* p = data();
+    char* t = result.get();
+    int base = 0;
+
+    for(int remaining = matches; remaining--;) {
+      int n = _search(p + base, size - base, from.data(), from.size()) - p;
+      memory::copy(t, p + base, n - base);
+      t += n - base;
+      memory::copy(t, to.data(), to.size());
+      t += to.size();
+      base = n + from.size();
+    }
+
+    memory::copy(t, p + base, size - base);
+    return operator=(move(result));
+  }
+
   //right-to-left expand
   else if(to.size() > from.size()) {
     resize(size + matches * (to.size() - from.size()));
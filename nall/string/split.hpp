@@ -13,8 +13,14 @@ auto string_vector::_split(string_view source, string_view find, long limit) ->
   int matches = 0;
 
   for(int n = 0, quoted = 0; n <= size - (int)find.size();) {
-    if(Quoted) { if(p[n] == '\"') { quoted ^= 1; n++; continue; } if(quoted) { n++; continue; } }
-    if(string::_compare<Insensitive>(p + n, size - n, find.data(), find.size())) { n++; continue; }
+    if(!Insensitive && !Quoted) {
+      auto match = string::_search(p + n, size - n, find.data(), find.size());
+      if(!match) break;
+      n = match - p;
+    } else {
+      if(Quoted) { if(p[n] == '\"') { quoted ^= 1; n++; continue; } if(quoted) { n++; continue; } }
+      if(string::_compare<Insensitive>(p + n, size - n, find.data(), find.size())) { n++; continue; }
+    }
     if(matches >= limit) break;
 
     string& s = operator()(matches);
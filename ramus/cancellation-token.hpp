@@ -0,0 +1,27 @@
+#pragma once
+
+//cooperative cancellation: long-running work polls the token wherever it can stop cleanly,
+//and whoever started the work cancels it from any thread, or from a signal handler
+//copies share one flag, so that a single token can stop several workers at once
+
+#include <atomic>
+#include <nall/shared-pointer.hpp>
+
+namespace ramus {
+
+using namespace nall;
+
+struct CancellationToken {
+  CancellationToken() : state(new std::atomic<bool>{false}) {}
+
+  auto cancel() -> void { state->store(true, std::memory_order_relaxed); }
+  auto reset() -> void { state->store(false, std::memory_order_relaxed); }
+
+  //true once cancelled; the flag guards no data, so no ordering is needed
+  explicit operator bool() const { return state->load(std::memory_order_relaxed); }
+
+private:
+  shared_pointer<std::atomic<bool>> state;
+};
+
+}
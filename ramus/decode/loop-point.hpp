@@ -0,0 +1,192 @@
+#pragma once
+
+//reads a track's loop start from container metadata
+//result is in samples at the source's own sampling frequency
+
+//RIFF WAVE: first sample loop of the "smpl" chunk
+//MP3:       ID3v2 TXXX frame with description LOOPSTART
+//Ogg:       Vorbis/Opus comment LOOPSTART
+//FLAC:      Vorbis comment LOOPSTART, then an APPLICATION "riff" block holding a "smpl" chunk
+//           (flac --keep-foreign-metadata), then the first nonzero CUESHEET index point
+
+#include <nall/maybe.hpp>
+#include <nall/memory.hpp>
+#include <nall/string.hpp>
+
+namespace ramus {
+
+using namespace nall;
+
+namespace Decode {
+
+namespace LoopPoint {
+  inline auto smpl(const uint8_t* data, uint size) -> maybe<uint> {
+    //36-byte header, then 24-byte loop records: {cue point ID, type, start, end, fraction, play count}
+    if(size < 36 + 24) return nothing;
+    if(memory::readl<4>(data + 28) == 0) return nothing;
+    return (uint)memory::readl<4>(data + 36 + 8);
+  }
+
+  inline auto riff(const uint8_t* data, uint size) -> maybe<uint> {
+    const uint8_t* end = data + size;
+    while(end - data >= 8) {
+      uint length = memory::readl<4>(data + 4);
+      if(length > end - data - 8) length = end - data - 8;
+      if(!memory::compare(data, "smpl", 4)) return smpl(data + 8, length);
+      data += 8 + length + (length & 1);
+    }
+    return nothing;
+  }
+
+  inline auto comment(const string& key, string value) -> maybe<uint> {
+    if(!key.iequals("LOOPSTART") && !key.iequals("LOOP_START")) return nothing;
+    value.strip();
+    if(!value) return nothing;
+    for(char c : value) if(c < '0' || c > '9') return nothing;
+    return (uint)value.natural();
+  }
+
+  //Vorbis comment block, as used by Ogg Vorbis, Ogg Opus and FLAC
+  inline auto vorbisComment(const uint8_t* data, uint size) -> maybe<uint> {
+    const uint8_t* end = data + size;
+    if(size < 8) return nothing;
+    uint vendor = memory::readl<4>(data);
+    if(vendor > size - 8) return nothing;
+    data += 4 + vendor;
+    uint count = memory::readl<4>(data);
+    data += 4;
+    while(count-- && end - data >= 4) {
+      uint length = memory::readl<4>(data);
+      data += 4;
+      if(length > end - data) break;
+      string entry;
+      entry.resize(length);
+      memory::copy(entry.get(), data, length);
+      data += length;
+      auto part = entry.split("=", 1L);
+      if(part.size() == 2) {
+        if(auto loop = comment(part[0], part[1])) return loop;
+      }
+    }
+    return nothing;
+  }
+
+  inline auto ogg(const uint8_t* data, uint size) -> maybe<uint> {
+    //reassemble the second packet (comment header) of the first logical stream
+    vector<uint8_t> packet;
+    uint packetIndex = 0;
+    uint offset = 0;
+    while(offset + 27 <= size && !memory::compare(data + offset, "OggS", 4)) {
+      uint segments = data[offset + 26];
+      if(offset + 27 + segments > size) break;
+      const uint8_t* lacing = data + offset + 27;
+      const uint8_t* body = lacing + segments;
+      for(uint n : range(segments)) {
+        if(body + lacing[n] > data + size) return nothing;
+        if(packetIndex == 1) for(uint byte : range(lacing[n])) packet.append(body[byte]);
+        body += lacing[n];
+        if(lacing[n] < 255) {
+          if(packetIndex++ == 1) {
+            if(packet.size() >= 7 && !memory::compare(packet.data(), "\x03vorbis", 7)) {
+              return vorbisComment(packet.data() + 7, packet.size() - 7);
+            }
+            if(packet.size() >= 8 && !memory::compare(packet.data(), "OpusTags", 8)) {
+              return vorbisComment(packet.data() + 8, packet.size() - 8);
+            }
+            return nothing;
+          }
+        }
+      }
+      offset = body - data;
+    }
+    return nothing;
+  }
+
+  inline auto flac(const uint8_t* data, uint size) -> maybe<uint> {
+    maybe<uint> application;
+    maybe<uint> cuesheet;
+    uint offset = 4;
+    while(offset + 4 <= size) {
+      bool last = data[offset] & 0x80;
+      uint type = data[offset] & 0x7f;
+      uint length = memory::readm<3>(data + offset + 1);
+      offset += 4;
+      if(length > size - offset) break;
+      const uint8_t* block = data + offset;
+
+      if(type == 4) {
+        if(auto loop = vorbisComment(block, length)) return loop;
+      }
+
+      if(type == 2 && length > 4 && !memory::compare(block, "riff", 4) && !application) {
+        application = riff(block + 4, length - 4);
+      }
+
+      if(type == 5 && length >= 396 && !cuesheet) {
+        //catalog (128), lead-in (8), flags and reserved (259), track count (1)
+        const uint8_t* track = block + 396;
+        const uint8_t* end = block + length;
+        for(uint tracks = block[395]; tracks && end - track >= 36; tracks--) {
+          uint64_t trackOffset = memory::readm<8>(track);
+          uint indices = track[35];
+          track += 36;
+          for(; indices && end - track >= 12; indices--) {
+            uint64_t point = trackOffset + memory::readm<8>(track);
+            track += 12;
+            if(point && !cuesheet) cuesheet = (uint)point;
+          }
+        }
+      }
+
+      offset += length;
+      if(last) break;
+    }
+    if(application) return application;
+    return cuesheet;
+  }
+
+  inline auto id3(const uint8_t* data, uint size) -> maybe<uint> {
+    if(size < 10) return nothing;
+    uint version = data[3];
+    if(version < 3) return nothing;
+    auto syncsafe = [](const uint8_t* p) -> uint {
+      return (p[0] & 0x7f) << 21 | (p[1] & 0x7f) << 14 | (p[2] & 0x7f) << 7 | (p[3] & 0x7f);
+    };
+    uint offset = 10;
+    uint end = min(size, 10 + syncsafe(data + 6));
+    if(data[5] & 0x40 && end >= 14) offset += version == 4 ? syncsafe(data + 10) : 4 + memory::readm<4>(data + 10);
+    while(offset + 10 <= end && data[offset]) {
+      uint frameSize = version == 4 ? syncsafe(data + offset + 4) : memory::readm<4>(data + offset + 4);
+      const uint8_t* frame = data + offset + 10;
+      if(frameSize > end - offset - 10) break;
+      //TXXX: encoding, description, NUL, value (Latin-1 and UTF-8 only)
+      if(!memory::compare(data + offset, "TXXX", 4) && frameSize > 1 && (frame[0] == 0 || frame[0] == 3)) {
+        string description, value;
+        uint n = 1;
+        for(; n < frameSize && frame[n]; n++) description.append((char)frame[n]);
+        for(n++; n < frameSize && frame[n]; n++) value.append((char)frame[n]);
+        if(auto loop = comment(description, value)) return loop;
+      }
+      offset += 10 + frameSize;
+    }
+    return nothing;
+  }
+}
+
+inline auto loopPoint(const uint8_t* data, uint size) -> maybe<uint> {
+  if(size >= 12 && !memory::compare(data, "RIFF", 4) && !memory::compare(data + 8, "WAVE", 4)) {
+    return LoopPoint::riff(data + 12, size - 12);
+  }
+  if(size >= 4 && !memory::compare(data, "OggS", 4)) return LoopPoint::ogg(data, size);
+  if(size >= 4 && !memory::compare(data, "fLaC", 4)) return LoopPoint::flac(data, size);
+  if(size >= 3 && !memory::compare(data, "ID3", 3)) return LoopPoint::id3(data, size);
+  return nothing;
+}
+
+inline auto loopPoint(const vector<uint8_t>& data) -> maybe<uint> {
+  return loopPoint(data.data(), data.size());
+}
+
+}
+
+}
@@ -0,0 +1,1392 @@
+#pragma once
+
+//MPEG-1, MPEG-2 and MPEG-2.5 Layer III decoder
+//frames are decoded on demand, so memory use does not grow with stream length
+//the input buffer is not copied and must outlive the decoder
+
+#include <nall/array.hpp>
+#include <nall/memory.hpp>
+#include <nall/stdint.hpp>
+#include <nall/vector.hpp>
+
+namespace ramus {
+
+using namespace nall;
+
+namespace Decode {
+
+struct MP3 {
+  inline MP3(const uint8_t* data, uint size);
+  inline MP3(const vector<uint8_t>& data);
+
+  inline auto sample() -> array<double, 2>;
+
+  inline explicit operator bool() const;
+
+  uint channels = 0;
+  uint frequency = 0;
+
+private:
+  enum Mode : uint { Stereo, JointStereo, DualChannel, Mono };
+
+  struct Header {
+    bool lsf;         //MPEG-2 or MPEG-2.5 (one granule per frame)
+    bool crc;
+    uint bitrate;
+    uint frequency;
+    uint sampleRate;  //index into scalefactor band tables (0-8)
+    uint mode;
+    uint modeExtension;
+    uint channels;
+    uint length;      //frame length in bytes, including the header
+  };
+
+  struct Granule {
+    uint part23Length;
+    uint bigValues;
+    uint globalGain;
+    uint scalefacCompress;
+    bool windowSwitching;
+    uint blockType;
+    bool mixedBlock;
+    uint tableSelect[3];
+    uint subblockGain[3];
+    uint region0Count;
+    uint region1Count;
+    bool preflag;
+    uint scalefacScale;
+    uint count1Table;
+  };
+
+  struct Channel {
+    uint8_t scalefacLong[22];
+    uint8_t scalefacShort[13][3];
+    uint8_t illegalLong[22];  //MPEG-2 intensity stereo: largest scalefactor value marks an illegal position
+    uint8_t illegalShort[13];
+    bool intensityScale;
+    int quantized[576];
+    double spectrum[576];
+    uint nonzero;             //spectral lines past this point are zero
+    double overlap[32][18];
+    double synthesis[1024];
+    uint synthesisOffset;
+  };
+
+  struct Tables {
+    inline Tables();
+
+    double power[8207];       //|x|^(4/3)
+    int16_t tree[1400][2];    //Huffman decoding trees; negative entries are leaves
+    uint treeRoot[16];
+    uint longBand[9][23];
+    uint shortBand[9][14];
+    double window[4][36];     //block type 0 (normal), 1 (start), 2 (short), 3 (stop)
+    double aliasS[8];
+    double aliasA[8];
+    double dct18[2][9][2];    //DCT-IV pre- and post-twiddles (cos, sin)
+    double dct6[2][3][2];
+    double dft9[3][3][2];     //radix-3 twiddles for the nine-point DFT
+    double dct32[31];         //fast DCT-II cosine reciprocals for matrixing
+    double synthesisWindow[512];
+    double intensityLeft[7];
+    double intensityRight[7];
+  };
+
+  static inline auto tables() -> const Tables&;
+
+  inline auto parseHeader(const uint8_t* data, Header& header) const -> bool;
+  inline auto synchronize() -> bool;
+  inline auto parseXing(const uint8_t* data) -> bool;
+  inline auto refill() -> void;
+  inline auto decodeFrame() -> bool;
+  inline auto readSideInformation() -> bool;
+  inline auto readScalefactors(uint gr, uint ch) -> void;
+  inline auto readScalefactorsLSF(uint ch) -> void;
+  inline auto readHuffman(uint gr, uint ch, uint part3End) -> void;
+  inline auto requantize(uint gr, uint ch) -> void;
+  inline auto stereo(uint gr) -> void;
+  inline auto reorder(uint gr, uint ch) -> void;
+  inline auto antialias(uint gr, uint ch) -> void;
+  inline auto hybridSynthesis(uint gr, uint ch) -> void;
+  inline auto polyphaseSynthesis(uint gr, uint ch) -> void;
+
+  inline auto bit() -> uint;
+  inline auto bits(uint count) -> uint;
+  inline auto huffman(uint table) -> uint;
+
+  static inline auto dft(double* re, double* im, uint size) -> void;
+  static inline auto imdct(const double* input, uint stride, double* output, uint size) -> void;
+  static inline auto dct(double* data, uint size, const double* twiddle) -> void;
+
+  const uint8_t* input = nullptr;
+  uint inputSize = 0;
+  uint inputOffset = 0;
+
+  Header header;
+  Granule granule[2][2];
+  uint scfsi[2];
+  uint mainDataBegin;
+  Channel channel[2];
+
+  uint8_t reservoir[4096];
+  uint reservoirSize = 0;
+
+  const uint8_t* bitData = nullptr;
+  uint bitPosition = 0;
+  uint bitLength = 0;
+
+  double time[18][32];
+  double pcm[1152][2];
+  uint pcmOffset = 0;
+  uint pcmSize = 0;
+
+  uint skip = 0;        //encoder and decoder delay to discard (from LAME tag)
+  uint remaining = ~0;  //samples left before encoder padding (from Xing/LAME tag)
+};
+
+//ISO/IEC 11172-3 Table B.7: Layer III Huffman code tables
+//entries are indexed by x * ysize + y; the last entry is count1 table A (indexed by vwxy)
+static const uint8_t mp3HuffmanLength[1394] = {
+    //table 1 (2x2)
+     1,  3,  2,  3,
+    //table 2 (3x3)
+     1,  3,  6,  3,  3,  5,  5,  5,  6,
+    //table 3 (3x3)
+     2,  2,  6,  3,  2,  5,  5,  5,  6,
+    //table 5 (4x4)
+     1,  3,  6,  7,  3,  3,  6,  7,  6,  6,  7,  8,  7,  6,  7,  8,
+    //table 6 (4x4)
+     3,  3,  5,  7,  3,  2,  4,  5,  4,  4,  5,  6,  6,  5,  6,  7,
+    //table 7 (6x6)
+     1,  3,  6,  8,  8,  9,  3,  4,  6,  7,  7,  8,  6,  5,  7,  8,
+     8,  9,  7,  7,  8,  9,  9,  9,  7,  7,  8,  9,  9, 10,  8,  8,
+     9, 10, 10, 10,
+    //table 8 (6x6)
+     2,  3,  6,  8,  8,  9,  3,  2,  4,  8,  8,  8,  6,  4,  6,  8,
+     8,  9,  8,  8,  8,  9,  9, 10,  8,  7,  8,  9, 10, 10,  9,  8,
+     9,  9, 11, 11,
+    //table 9 (6x6)
+     3,  3,  5,  6,  8,  9,  3,  3,  4,  5,  6,  8,  4,  4,  5,  6,
+     7,  8,  6,  5,  6,  7,  7,  8,  7,  6,  7,  7,  8,  9,  8,  7,
+     8,  8,  9,  9,
+    //table 10 (8x8)
+     1,  3,  6,  8,  9,  9,  9, 10,  3,  4,  6,  7,  8,  9,  8,  8,
+     6,  6,  7,  8,  9, 10,  9,  9,  7,  7,  8,  9, 10, 10,  9, 10,
+     8,  8,  9, 10, 10, 10, 10, 10,  9,  9, 10, 10, 11, 11, 10, 11,
+     8,  8,  9, 10, 10, 10, 11, 11,  9,  8,  9, 10, 10, 11, 11, 11,
+    //table 11 (8x8)
+     2,  3,  5,  7,  8,  9,  8,  9,  3,  3,  4,  6,  8,  8,  7,  8,
+     5,  5,  6,  7,  8,  9,  8,  8,  7,  6,  7,  9,  8, 10,  8,  9,
+     8,  8,  8,  9,  9, 10,  9, 10,  8,  8,  9, 10, 10, 11, 10, 11,
+     8,  7,  7,  8,  9, 10, 10, 10,  8,  7,  8,  9, 10, 10, 10, 10,
+    //table 12 (8x8)
+     4,  3,  5,  7,  8,  9,  9,  9,  3,  3,  4,  5,  7,  7,  8,  8,
+     5,  4,  5,  6,  7,  8,  7,  8,  6,  5,  6,  6,  7,  8,  8,  8,
+     7,  6,  7,  7,  8,  8,  8,  9,  8,  7,  8,  8,  8,  9,  8,  9,
+     8,  7,  7,  8,  8,  9,  9, 10,  9,  8,  8,  9,  9,  9,  9, 10,
+    //table 13 (16x16)
+     1,  4,  6,  7,  8,  9,  9, 10,  9, 10, 11, 11, 12, 12, 13, 13,
+     3,  4,  6,  7,  8,  8,  9,  9,  9,  9, 10, 10, 11, 12, 12, 12,
+     6,  6,  7,  8,  9,  9, 10, 10,  9, 10, 10, 11, 11, 12, 13, 13,
+     7,  7,  8,  9,  9, 10, 10, 10, 10, 11, 11, 11, 11, 12, 13, 13,
+     8,  7,  9,  9, 10, 10, 11, 11, 10, 11, 11, 12, 12, 13, 13, 14,
+     9,  8,  9, 10, 10, 10, 11, 11, 11, 11, 12, 11, 13, 13, 14, 14,
+     9,  9, 10, 10, 11, 11, 11, 11, 11, 12, 12, 12, 13, 13, 14, 14,
+    10,  9, 10, 11, 11, 11, 12, 12, 12, 12, 13, 13, 13, 14, 16, 16,
+     9,  8,  9, 10, 10, 11, 11, 12, 12, 12, 12, 13, 13, 14, 15, 15,
+    10,  9, 10, 10, 11, 11, 11, 13, 12, 13, 13, 14, 14, 14, 16, 15,
+    10, 10, 10, 11, 11, 12, 12, 13, 12, 13, 14, 13, 14, 15, 16, 17,
+    11, 10, 10, 11, 12, 12, 12, 12, 13, 13, 13, 14, 15, 15, 15, 16,
+    11, 11, 11, 12, 12, 13, 12, 13, 14, 14, 15, 15, 15, 16, 16, 16,
+    12, 11, 12, 13, 13, 13, 14, 14, 14, 14, 14, 15, 16, 15, 16, 16,
+    13, 12, 12, 13, 13, 13, 15, 14, 14, 17, 15, 15, 15, 17, 16, 16,
+    12, 12, 13, 14, 14, 14, 15, 14, 15, 15, 16, 16, 19, 18, 19, 16,
+    //table 15 (16x16)
+     3,  4,  5,  7,  7,  8,  9,  9,  9, 10, 10, 11, 11, 11, 12, 13,
+     4,  3,  5,  6,  7,  7,  8,  8,  8,  9,  9, 10, 10, 10, 11, 11,
+     5,  5,  5,  6,  7,  7,  8,  8,  8,  9,  9, 10, 10, 11, 11, 11,
+     6,  6,  6,  7,  7,  8,  8,  9,  9,  9, 10, 10, 10, 11, 11, 11,
+     7,  6,  7,  7,  8,  8,  9,  9,  9,  9, 10, 10, 10, 11, 11, 11,
+     8,  7,  7,  8,  8,  8,  9,  9,  9,  9, 10, 10, 11, 11, 11, 12,
+     9,  7,  8,  8,  8,  9,  9,  9,  9, 10, 10, 10, 11, 11, 12, 12,
+     9,  8,  8,  9,  9,  9,  9, 10, 10, 10, 10, 10, 11, 11, 11, 12,
+     9,  8,  8,  9,  9,  9,  9, 10, 10, 10, 10, 11, 11, 12, 12, 12,
+     9,  8,  9,  9,  9,  9, 10, 10, 10, 11, 11, 11, 11, 12, 12, 12,
+    10,  9,  9,  9, 10, 10, 10, 10, 10, 11, 11, 11, 11, 12, 13, 12,
+    10,  9,  9,  9, 10, 10, 10, 10, 11, 11, 11, 11, 12, 12, 12, 13,
+    11, 10,  9, 10, 10, 10, 11, 11, 11, 11, 11, 11, 12, 12, 13, 13,
+    11, 10, 10, 10, 10, 11, 11, 11, 11, 12, 12, 12, 12, 12, 13, 13,
+    12, 11, 11, 11, 11, 11, 11, 11, 12, 12, 12, 12, 13, 13, 12, 13,
+    12, 11, 11, 11, 11, 11, 11, 12, 12, 12, 12, 12, 13, 13, 13, 13,
+    //table 16 (16x16)
+     1,  4,  6,  8,  9,  9, 10, 10, 11, 11, 11, 12, 12, 12, 13,  9,
+     3,  4,  6,  7,  8,  9,  9,  9, 10, 10, 10, 11, 12, 11, 12,  8,
+     6,  6,  7,  8,  9,  9, 10, 10, 11, 10, 11, 11, 11, 12, 12,  9,
+     8,  7,  8,  9,  9, 10, 10, 10, 11, 11, 12, 12, 12, 13, 13, 10,
+     9,  8,  9,  9, 10, 10, 11, 11, 11, 12, 12, 12, 13, 13, 13,  9,
+     9,  8,  9,  9, 10, 11, 11, 12, 11, 12, 12, 13, 13, 13, 14, 10,
+    10,  9,  9, 10, 11, 11, 11, 11, 12, 12, 12, 12, 13, 13, 14, 10,
+    10,  9, 10, 10, 11, 11, 11, 12, 12, 13, 13, 13, 13, 15, 15, 10,
+    10, 10, 10, 11, 11, 11, 12, 12, 13, 13, 13, 13, 14, 14, 14, 10,
+    11, 10, 10, 11, 11, 12, 12, 13, 13, 13, 13, 14, 13, 14, 13, 11,
+    11, 11, 10, 11, 12, 12, 12, 12, 13, 14, 14, 14, 15, 15, 14, 10,
+    12, 11, 11, 11, 12, 12, 13, 14, 14, 14, 14, 14, 14, 13, 14, 11,
+    12, 12, 12, 12, 12, 13, 13, 13, 13, 15, 14, 14, 14, 14, 16, 11,
+    14, 12, 12, 12, 13, 13, 14, 14, 14, 16, 15, 15, 15, 17, 15, 11,
+    13, 13, 11, 12, 14, 14, 13, 14, 14, 15, 16, 15, 17, 15, 14, 11,
+     9,  8,  8,  9,  9, 10, 10, 10, 11, 11, 11, 11, 11, 11, 11,  8,
+    //table 24 (16x16)
+     4,  4,  6,  7,  8,  9,  9, 10, 10, 11, 11, 11, 11, 11, 12,  9,
+     4,  4,  5,  6,  7,  8,  8,  9,  9,  9, 10, 10, 10, 10, 10,  8,
+     6,  5,  6,  7,  7,  8,  8,  9,  9,  9,  9, 10, 10, 10, 11,  7,
+     7,  6,  7,  7,  8,  8,  8,  9,  9,  9,  9, 10, 10, 10, 10,  7,
+     8,  7,  7,  8,  8,  8,  8,  9,  9,  9, 10, 10, 10, 10, 11,  7,
+     9,  7,  8,  8,  8,  8,  9,  9,  9,  9, 10, 10, 10, 10, 10,  7,
+     9,  8,  8,  8,  8,  9,  9,  9,  9, 10, 10, 10, 10, 10, 11,  7,
+    10,  8,  8,  8,  9,  9,  9,  9, 10, 10, 10, 10, 10, 11, 11,  8,
+    10,  9,  9,  9,  9,  9,  9,  9,  9, 10, 10, 10, 10, 11, 11,  8,
+    10,  9,  9,  9,  9,  9,  9, 10, 10, 10, 10, 10, 11, 11, 11,  8,
+    11,  9,  9,  9,  9, 10, 10, 10, 10, 10, 10, 11, 11, 11, 11,  8,
+    11, 10,  9,  9,  9, 10, 10, 10, 10, 10, 10, 11, 11, 11, 11,  8,
+    11, 10, 10, 10, 10, 10, 10, 10, 10, 10, 11, 11, 11, 11, 11,  8,
+    11, 10, 10, 10, 10, 10, 10, 10, 11, 11, 11, 11, 11, 11, 11,  8,
+    12, 10, 10, 10, 10, 10, 10, 11, 11, 11, 11, 11, 11, 11, 11,  8,
+     8,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  8,  8,  8,  8,  4,
+    //count1 table A
+     1,  4,  4,  5,  4,  6,  5,  6,  4,  5,  5,  6,  5,  6,  6,  6,
+};
+
+static const uint32_t mp3HuffmanCode[1394] = {
+    //table 1 (2x2)
+    0x00001, 0x00001, 0x00001, 0x00000,
+    //table 2 (3x3)
+    0x00001, 0x00002, 0x00001, 0x00003, 0x00001, 0x00001, 0x00003, 0x00002,
+    0x00000,
+    //table 3 (3x3)
+    0x00003, 0x00002, 0x00001, 0x00001, 0x00001, 0x00001, 0x00003, 0x00002,
+    0x00000,
+    //table 5 (4x4)
+    0x00001, 0x00002, 0x00006, 0x00005, 0x00003, 0x00001, 0x00004, 0x00004,
+    0x00007, 0x00005, 0x00007, 0x00001, 0x00006, 0x00001, 0x00001, 0x00000,
+    //table 6 (4x4)
+    0x00007, 0x00003, 0x00005, 0x00001, 0x00006, 0x00002, 0x00003, 0x00002,
+    0x00005, 0x00004, 0x00004, 0x00001, 0x00003, 0x00003, 0x00002, 0x00000,
+    //table 7 (6x6)
+    0x00001, 0x00002, 0x0000a, 0x00013, 0x00010, 0x0000a, 0x00003, 0x00003,
+    0x00007, 0x0000a, 0x00005, 0x00003, 0x0000b, 0x00004, 0x0000d, 0x00011,
+    0x00008, 0x00004, 0x0000c, 0x0000b, 0x00012, 0x0000f, 0x0000b, 0x00002,
+    0x00007, 0x00006, 0x00009, 0x0000e, 0x00003, 0x00001, 0x00006, 0x00004,
+    0x00005, 0x00003, 0x00002, 0x00000,
+    //table 8 (6x6)
+    0x00003, 0x00004, 0x00006, 0x00012, 0x0000c, 0x00005, 0x00005, 0x00001,
+    0x00002, 0x00010, 0x00009, 0x00003, 0x00007, 0x00003, 0x00005, 0x0000e,
+    0x00007, 0x00003, 0x00013, 0x00011, 0x0000f, 0x0000d, 0x0000a, 0x00004,
+    0x0000d, 0x00005, 0x00008, 0x0000b, 0x00005, 0x00001, 0x0000c, 0x00004,
+    0x00004, 0x00001, 0x00001, 0x00000,
+    //table 9 (6x6)
+    0x00007, 0x00005, 0x00009, 0x0000e, 0x0000f, 0x00007, 0x00006, 0x00004,
+    0x00005, 0x00005, 0x00006, 0x00007, 0x00007, 0x00006, 0x00008, 0x00008,
+    0x00008, 0x00005, 0x0000f, 0x00006, 0x00009, 0x0000a, 0x00005, 0x00001,
+    0x0000b, 0x00007, 0x00009, 0x00006, 0x00004, 0x00001, 0x0000e, 0x00004,
+    0x00006, 0x00002, 0x00006, 0x00000,
+    //table 10 (8x8)
+    0x00001, 0x00002, 0x0000a, 0x00017, 0x00023, 0x0001e, 0x0000c, 0x00011,
+    0x00003, 0x00003, 0x00008, 0x0000c, 0x00012, 0x00015, 0x0000c, 0x00007,
+    0x0000b, 0x00009, 0x0000f, 0x00015, 0x00020, 0x00028, 0x00013, 0x00006,
+    0x0000e, 0x0000d, 0x00016, 0x00022, 0x0002e, 0x00017, 0x00012, 0x00007,
+    0x00014, 0x00013, 0x00021, 0x0002f, 0x0001b, 0x00016, 0x00009, 0x00003,
+    0x0001f, 0x00016, 0x00029, 0x0001a, 0x00015, 0x00014, 0x00005, 0x00003,
+    0x0000e, 0x0000d, 0x0000a, 0x0000b, 0x00010, 0x00006, 0x00005, 0x00001,
+    0x00009, 0x00008, 0x00007, 0x00008, 0x00004, 0x00004, 0x00002, 0x00000,
+    //table 11 (8x8)
+    0x00003, 0x00004, 0x0000a, 0x00018, 0x00022, 0x00021, 0x00015, 0x0000f,
+    0x00005, 0x00003, 0x00004, 0x0000a, 0x00020, 0x00011, 0x0000b, 0x0000a,
+    0x0000b, 0x00007, 0x0000d, 0x00012, 0x0001e, 0x0001f, 0x00014, 0x00005,
+    0x00019, 0x0000b, 0x00013, 0x0003b, 0x0001b, 0x00012, 0x0000c, 0x00005,
+    0x00023, 0x00021, 0x0001f, 0x0003a, 0x0001e, 0x00010, 0x00007, 0x00005,
+    0x0001c, 0x0001a, 0x00020, 0x00013, 0x00011, 0x0000f, 0x00008, 0x0000e,
+    0x0000e, 0x0000c, 0x00009, 0x0000d, 0x0000e, 0x00009, 0x00004, 0x00001,
+    0x0000b, 0x00004, 0x00006, 0x00006, 0x00006, 0x00003, 0x00002, 0x00000,
+    //table 12 (8x8)
+    0x00009, 0x00006, 0x00010, 0x00021, 0x00029, 0x00027, 0x00026, 0x0001a,
+    0x00007, 0x00005, 0x00006, 0x00009, 0x00017, 0x00010, 0x0001a, 0x0000b,
+    0x00011, 0x00007, 0x0000b, 0x0000e, 0x00015, 0x0001e, 0x0000a, 0x00007,
+    0x00011, 0x0000a, 0x0000f, 0x0000c, 0x00012, 0x0001c, 0x0000e, 0x00005,
+    0x00020, 0x0000d, 0x00016, 0x00013, 0x00012, 0x00010, 0x00009, 0x00005,
+    0x00028, 0x00011, 0x0001f, 0x0001d, 0x00011, 0x0000d, 0x00004, 0x00002,
+    0x0001b, 0x0000c, 0x0000b, 0x0000f, 0x0000a, 0x00007, 0x00004, 0x00001,
+    0x0001b, 0x0000c, 0x00008, 0x0000c, 0x00006, 0x00003, 0x00001, 0x00000,
+    //table 13 (16x16)
+    0x00001, 0x00005, 0x0000e, 0x00015, 0x00022, 0x00033, 0x0002e, 0x00047,
+    0x0002a, 0x00034, 0x00044, 0x00034, 0x00043, 0x0002c, 0x0002b, 0x00013,
+    0x00003, 0x00004, 0x0000c, 0x00013, 0x0001f, 0x0001a, 0x0002c, 0x00021,
+    0x0001f, 0x00018, 0x00020, 0x00018, 0x0001f, 0x00023, 0x00016, 0x0000e,
+    0x0000f, 0x0000d, 0x00017, 0x00024, 0x0003b, 0x00031, 0x0004d, 0x00041,
+    0x0001d, 0x00028, 0x0001e, 0x00028, 0x0001b, 0x00021, 0x0002a, 0x00010,
+    0x00016, 0x00014, 0x00025, 0x0003d, 0x00038, 0x0004f, 0x00049, 0x00040,
+    0x0002b, 0x0004c, 0x00038, 0x00025, 0x0001a, 0x0001f, 0x00019, 0x0000e,
+    0x00023, 0x00010, 0x0003c, 0x00039, 0x00061, 0x0004b, 0x00072, 0x0005b,
+    0x00036, 0x00049, 0x00037, 0x00029, 0x00030, 0x00035, 0x00017, 0x00018,
+    0x0003a, 0x0001b, 0x00032, 0x00060, 0x0004c, 0x00046, 0x0005d, 0x00054,
+    0x0004d, 0x0003a, 0x0004f, 0x0001d, 0x0004a, 0x00031, 0x00029, 0x00011,
+    0x0002f, 0x0002d, 0x0004e, 0x0004a, 0x00073, 0x0005e, 0x0005a, 0x0004f,
+    0x00045, 0x00053, 0x00047, 0x00032, 0x0003b, 0x00026, 0x00024, 0x0000f,
+    0x00048, 0x00022, 0x00038, 0x0005f, 0x0005c, 0x00055, 0x0005b, 0x0005a,
+    0x00056, 0x00049, 0x0004d, 0x00041, 0x00033, 0x0002c, 0x0002b, 0x0002a,
+    0x0002b, 0x00014, 0x0001e, 0x0002c, 0x00037, 0x0004e, 0x00048, 0x00057,
+    0x0004e, 0x0003d, 0x0002e, 0x00036, 0x00025, 0x0001e, 0x00014, 0x00010,
+    0x00035, 0x00019, 0x00029, 0x00025, 0x0002c, 0x0003b, 0x00036, 0x00051,
+    0x00042, 0x0004c, 0x00039, 0x00036, 0x00025, 0x00012, 0x00027, 0x0000b,
+    0x00023, 0x00021, 0x0001f, 0x00039, 0x0002a, 0x00052, 0x00048, 0x00050,
+    0x0002f, 0x0003a, 0x00037, 0x00015, 0x00016, 0x0001a, 0x00026, 0x00016,
+    0x00035, 0x00019, 0x00017, 0x00026, 0x00046, 0x0003c, 0x00033, 0x00024,
+    0x00037, 0x0001a, 0x00022, 0x00017, 0x0001b, 0x0000e, 0x00009, 0x00007,
+    0x00022, 0x00020, 0x0001c, 0x00027, 0x00031, 0x0004b, 0x0001e, 0x00034,
+    0x00030, 0x00028, 0x00034, 0x0001c, 0x00012, 0x00011, 0x00009, 0x00005,
+    0x0002d, 0x00015, 0x00022, 0x00040, 0x00038, 0x00032, 0x00031, 0x0002d,
+    0x0001f, 0x00013, 0x0000c, 0x0000f, 0x0000a, 0x00007, 0x00006, 0x00003,
+    0x00030, 0x00017, 0x00014, 0x00027, 0x00024, 0x00023, 0x00035, 0x00015,
+    0x00010, 0x00017, 0x0000d, 0x0000a, 0x00006, 0x00001, 0x00004, 0x00002,
+    0x00010, 0x0000f, 0x00011, 0x0001b, 0x00019, 0x00014, 0x0001d, 0x0000b,
+    0x00011, 0x0000c, 0x00010, 0x00008, 0x00001, 0x00001, 0x00000, 0x00001,
+    //table 15 (16x16)
+    0x00007, 0x0000c, 0x00012, 0x00035, 0x0002f, 0x0004c, 0x0007c, 0x0006c,
+    0x00059, 0x0007b, 0x0006c, 0x00077, 0x0006b, 0x00051, 0x0007a, 0x0003f,
+    0x0000d, 0x00005, 0x00010, 0x0001b, 0x0002e, 0x00024, 0x0003d, 0x00033,
+    0x0002a, 0x00046, 0x00034, 0x00053, 0x00041, 0x00029, 0x0003b, 0x00024,
+    0x00013, 0x00011, 0x0000f, 0x00018, 0x00029, 0x00022, 0x0003b, 0x00030,
+    0x00028, 0x00040, 0x00032, 0x0004e, 0x0003e, 0x00050, 0x00038, 0x00021,
+    0x0001d, 0x0001c, 0x00019, 0x0002b, 0x00027, 0x0003f, 0x00037, 0x0005d,
+    0x0004c, 0x0003b, 0x0005d, 0x00048, 0x00036, 0x0004b, 0x00032, 0x0001d,
+    0x00034, 0x00016, 0x0002a, 0x00028, 0x00043, 0x00039, 0x0005f, 0x0004f,
+    0x00048, 0x00039, 0x00059, 0x00045, 0x00031, 0x00042, 0x0002e, 0x0001b,
+    0x0004d, 0x00025, 0x00023, 0x00042, 0x0003a, 0x00034, 0x0005b, 0x0004a,
+    0x0003e, 0x00030, 0x0004f, 0x0003f, 0x0005a, 0x0003e, 0x00028, 0x00026,
+    0x0007d, 0x00020, 0x0003c, 0x00038, 0x00032, 0x0005c, 0x0004e, 0x00041,
+    0x00037, 0x00057, 0x00047, 0x00033, 0x00049, 0x00033, 0x00046, 0x0001e,
+    0x0006d, 0x00035, 0x00031, 0x0005e, 0x00058, 0x0004b, 0x00042, 0x0007a,
+    0x0005b, 0x00049, 0x00038, 0x0002a, 0x00040, 0x0002c, 0x00015, 0x00019,
+    0x0005a, 0x0002b, 0x00029, 0x0004d, 0x00049, 0x0003f, 0x00038, 0x0005c,
+    0x0004d, 0x00042, 0x0002f, 0x00043, 0x00030, 0x00035, 0x00024, 0x00014,
+    0x00047, 0x00022, 0x00043, 0x0003c, 0x0003a, 0x00031, 0x00058, 0x0004c,
+    0x00043, 0x0006a, 0x00047, 0x00036, 0x00026, 0x00027, 0x00017, 0x0000f,
+    0x0006d, 0x00035, 0x00033, 0x0002f, 0x0005a, 0x00052, 0x0003a, 0x00039,
+    0x00030, 0x00048, 0x00039, 0x00029, 0x00017, 0x0001b, 0x0003e, 0x00009,
+    0x00056, 0x0002a, 0x00028, 0x00025, 0x00046, 0x00040, 0x00034, 0x0002b,
+    0x00046, 0x00037, 0x0002a, 0x00019, 0x0001d, 0x00012, 0x0000b, 0x0000b,
+    0x00076, 0x00044, 0x0001e, 0x00037, 0x00032, 0x0002e, 0x0004a, 0x00041,
+    0x00031, 0x00027, 0x00018, 0x00010, 0x00016, 0x0000d, 0x0000e, 0x00007,
+    0x0005b, 0x0002c, 0x00027, 0x00026, 0x00022, 0x0003f, 0x00034, 0x0002d,
+    0x0001f, 0x00034, 0x0001c, 0x00013, 0x0000e, 0x00008, 0x00009, 0x00003,
+    0x0007b, 0x0003c, 0x0003a, 0x00035, 0x0002f, 0x0002b, 0x00020, 0x00016,
+    0x00025, 0x00018, 0x00011, 0x0000c, 0x0000f, 0x0000a, 0x00002, 0x00001,
+    0x00047, 0x00025, 0x00022, 0x0001e, 0x0001c, 0x00014, 0x00011, 0x0001a,
+    0x00015, 0x00010, 0x0000a, 0x00006, 0x00008, 0x00006, 0x00002, 0x00000,
+    //table 16 (16x16)
+    0x00001, 0x00005, 0x0000e, 0x0002c, 0x0004a, 0x0003f, 0x0006e, 0x0005d,
+    0x000ac, 0x00095, 0x0008a, 0x000f2, 0x000e1, 0x000c3, 0x00178, 0x00011,
+    0x00003, 0x00004, 0x0000c, 0x00014, 0x00023, 0x0003e, 0x00035, 0x0002f,
+    0x00053, 0x0004b, 0x00044, 0x00077, 0x000c9, 0x0006b, 0x000cf, 0x00009,
+    0x0000f, 0x0000d, 0x00017, 0x00026, 0x00043, 0x0003a, 0x00067, 0x0005a,
+    0x000a1, 0x00048, 0x0007f, 0x00075, 0x0006e, 0x000d1, 0x000ce, 0x00010,
+    0x0002d, 0x00015, 0x00027, 0x00045, 0x00040, 0x00072, 0x00063, 0x00057,
+    0x0009e, 0x0008c, 0x000fc, 0x000d4, 0x000c7, 0x00183, 0x0016d, 0x0001a,
+    0x0004b, 0x00024, 0x00044, 0x00041, 0x00073, 0x00065, 0x000b3, 0x000a4,
+    0x0009b, 0x00108, 0x000f6, 0x000e2, 0x0018b, 0x0017e, 0x0016a, 0x00009,
+    0x00042, 0x0001e, 0x0003b, 0x00038, 0x00066, 0x000b9, 0x000ad, 0x00109,
+    0x0008e, 0x000fd, 0x000e8, 0x00190, 0x00184, 0x0017a, 0x001bd, 0x00010,
+    0x0006f, 0x00036, 0x00034, 0x00064, 0x000b8, 0x000b2, 0x000a0, 0x00085,
+    0x00101, 0x000f4, 0x000e4, 0x000d9, 0x00181, 0x0016e, 0x002cb, 0x0000a,
+    0x00062, 0x00030, 0x0005b, 0x00058, 0x000a5, 0x0009d, 0x00094, 0x00105,
+    0x000f8, 0x00197, 0x0018d, 0x00174, 0x0017c, 0x00379, 0x00374, 0x00008,
+    0x00055, 0x00054, 0x00051, 0x0009f, 0x0009c, 0x0008f, 0x00104, 0x000f9,
+    0x001ab, 0x00191, 0x00188, 0x0017f, 0x002d7, 0x002c9, 0x002c4, 0x00007,
+    0x0009a, 0x0004c, 0x00049, 0x0008d, 0x00083, 0x00100, 0x000f5, 0x001aa,
+    0x00196, 0x0018a, 0x00180, 0x002df, 0x00167, 0x002c6, 0x00160, 0x0000b,
+    0x0008b, 0x00081, 0x00043, 0x0007d, 0x000f7, 0x000e9, 0x000e5, 0x000db,
+    0x00189, 0x002e7, 0x002e1, 0x002d0, 0x00375, 0x00372, 0x001b7, 0x00004,
+    0x000f3, 0x00078, 0x00076, 0x00073, 0x000e3, 0x000df, 0x0018c, 0x002ea,
+    0x002e6, 0x002e0, 0x002d1, 0x002c8, 0x002c2, 0x000df, 0x001b4, 0x00006,
+    0x000ca, 0x000e0, 0x000de, 0x000da, 0x000d8, 0x00185, 0x00182, 0x0017d,
+    0x0016c, 0x00378, 0x001bb, 0x002c3, 0x001b8, 0x001b5, 0x006c0, 0x00004,
+    0x002eb, 0x000d3, 0x000d2, 0x000d0, 0x00172, 0x0017b, 0x002de, 0x002d3,
+    0x002ca, 0x006c7, 0x00373, 0x0036d, 0x0036c, 0x00d83, 0x00361, 0x00002,
+    0x00179, 0x00171, 0x00066, 0x000bb, 0x002d6, 0x002d2, 0x00166, 0x002c7,
+    0x002c5, 0x00362, 0x006c6, 0x00367, 0x00d82, 0x00366, 0x001b2, 0x00000,
+    0x0000c, 0x0000a, 0x00007, 0x0000b, 0x0000a, 0x00011, 0x0000b, 0x00009,
+    0x0000d, 0x0000c, 0x0000a, 0x00007, 0x00005, 0x00003, 0x00001, 0x00003,
+    //table 24 (16x16)
+    0x0000f, 0x0000d, 0x0002e, 0x00050, 0x00092, 0x00106, 0x000f8, 0x001b2,
+    0x001aa, 0x0029d, 0x0028d, 0x00289, 0x0026d, 0x00205, 0x00408, 0x00058,
+    0x0000e, 0x0000c, 0x00015, 0x00026, 0x00047, 0x00082, 0x0007a, 0x000d8,
+    0x000d1, 0x000c6, 0x00147, 0x00159, 0x0013f, 0x00129, 0x00117, 0x0002a,
+    0x0002f, 0x00016, 0x00029, 0x0004a, 0x00044, 0x00080, 0x00078, 0x000dd,
+    0x000cf, 0x000c2, 0x000b6, 0x00154, 0x0013b, 0x00127, 0x0021d, 0x00012,
+    0x00051, 0x00027, 0x0004b, 0x00046, 0x00086, 0x0007d, 0x00074, 0x000dc,
+    0x000cc, 0x000be, 0x000b2, 0x00145, 0x00137, 0x00125, 0x0010f, 0x00010,
+    0x00093, 0x00048, 0x00045, 0x00087, 0x0007f, 0x00076, 0x00070, 0x000d2,
+    0x000c8, 0x000bc, 0x00160, 0x00143, 0x00132, 0x0011d, 0x0021c, 0x0000e,
+    0x00107, 0x00042, 0x00081, 0x0007e, 0x00077, 0x00072, 0x000d6, 0x000ca,
+    0x000c0, 0x000b4, 0x00155, 0x0013d, 0x0012d, 0x00119, 0x00106, 0x0000c,
+    0x000f9, 0x0007b, 0x00079, 0x00075, 0x00071, 0x000d7, 0x000ce, 0x000c3,
+    0x000b9, 0x0015b, 0x0014a, 0x00134, 0x00123, 0x00110, 0x00208, 0x0000a,
+    0x001b3, 0x00073, 0x0006f, 0x0006d, 0x000d3, 0x000cb, 0x000c4, 0x000bb,
+    0x00161, 0x0014c, 0x00139, 0x0012a, 0x0011b, 0x00213, 0x0017d, 0x00011,
+    0x001ab, 0x000d4, 0x000d0, 0x000cd, 0x000c9, 0x000c1, 0x000ba, 0x000b1,
+    0x000a9, 0x00140, 0x0012f, 0x0011e, 0x0010c, 0x00202, 0x00179, 0x00010,
+    0x0014f, 0x000c7, 0x000c5, 0x000bf, 0x000bd, 0x000b5, 0x000ae, 0x0014d,
+    0x00141, 0x00131, 0x00121, 0x00113, 0x00209, 0x0017b, 0x00173, 0x0000b,
+    0x0029c, 0x000b8, 0x000b7, 0x000b3, 0x000af, 0x00158, 0x0014b, 0x0013a,
+    0x00130, 0x00122, 0x00115, 0x00212, 0x0017f, 0x00175, 0x0016e, 0x0000a,
+    0x0028c, 0x0015a, 0x000ab, 0x000a8, 0x000a4, 0x0013e, 0x00135, 0x0012b,
+    0x0011f, 0x00114, 0x00107, 0x00201, 0x00177, 0x00170, 0x0016a, 0x00006,
+    0x00288, 0x00142, 0x0013c, 0x00138, 0x00133, 0x0012e, 0x00124, 0x0011c,
+    0x0010d, 0x00105, 0x00200, 0x00178, 0x00172, 0x0016c, 0x00167, 0x00004,
+    0x0026c, 0x0012c, 0x00128, 0x00126, 0x00120, 0x0011a, 0x00111, 0x0010a,
+    0x00203, 0x0017c, 0x00176, 0x00171, 0x0016d, 0x00169, 0x00165, 0x00002,
+    0x00409, 0x00118, 0x00116, 0x00112, 0x0010b, 0x00108, 0x00103, 0x0017e,
+    0x0017a, 0x00174, 0x0016f, 0x0016b, 0x00168, 0x00166, 0x00164, 0x00000,
+    0x0002b, 0x00014, 0x00013, 0x00011, 0x0000f, 0x0000d, 0x0000b, 0x00009,
+    0x00007, 0x00006, 0x00004, 0x00007, 0x00005, 0x00003, 0x00001, 0x00003,
+    //count1 table A
+    0x00001, 0x00005, 0x00004, 0x00005, 0x00006, 0x00005, 0x00004, 0x00004,
+    0x00007, 0x00003, 0x00006, 0x00000, 0x00007, 0x00002, 0x00003, 0x00001,
+};
+
+static const uint8_t mp3HuffmanSize[16] = {2, 3, 3, 4, 4, 6, 6, 6, 8, 8, 8, 16, 16, 16, 16, 4};
+
+//table_select to code table (-1 = no table) and linbits
+static const int8_t mp3HuffmanTable[32] = {
+  -1,  0,  1,  2, -1,  3,  4,  5,  6,  7,  8,  9, 10, 11, -1, 12,
+  13, 13, 13, 13, 13, 13, 13, 13, 14, 14, 14, 14, 14, 14, 14, 14,
+};
+
+static const uint8_t mp3Linbits[32] = {
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   1,  2,  3,  4,  6,  8, 10, 13,  4,  5,  6,  7,  8,  9, 11, 13,
+};
+
+//scalefactor band widths: 44100, 48000, 32000, 22050, 24000, 16000, 11025, 12000, 8000 Hz
+static const uint8_t mp3LongBandWidth[9][22] = {
+  { 4,  4,  4,  4,  4,  4,  6,  6,  8,  8, 10, 12, 16, 20, 24, 28, 34, 42, 50, 54, 76, 158},
+  { 4,  4,  4,  4,  4,  4,  6,  6,  6,  8, 10, 12, 16, 18, 22, 28, 34, 40, 46, 54, 54, 192},
+  { 4,  4,  4,  4,  4,  4,  6,  6,  8, 10, 12, 16, 20, 24, 30, 38, 46, 56, 68, 84, 102, 26},
+  { 6,  6,  6,  6,  6,  6,  8, 10, 12, 14, 16, 20, 24, 28, 32, 38, 46, 52, 60, 68, 58, 54},
+  { 6,  6,  6,  6,  6,  6,  8, 10, 12, 14, 16, 18, 22, 26, 32, 38, 46, 54, 62, 70, 76, 36},
+  { 6,  6,  6,  6,  6,  6,  8, 10, 12, 14, 16, 20, 24, 28, 32, 38, 46, 52, 60, 68, 58, 54},
+  { 6,  6,  6,  6,  6,  6,  8, 10, 12, 14, 16, 20, 24, 28, 32, 38, 46, 52, 60, 68, 58, 54},
+  { 6,  6,  6,  6,  6,  6,  8, 10, 12, 14, 16, 20, 24, 28, 32, 38, 46, 52, 60, 68, 58, 54},
+  {12, 12, 12, 12, 12, 12, 16, 20, 24, 28, 32, 40, 48, 56, 64, 76, 90,  2,  2,  2,  2,  2},
+};
+
+static const uint8_t mp3ShortBandWidth[9][13] = {
+  { 4,  4,  4,  4,  6,  8, 10, 12, 14, 18, 22, 30, 56},
+  { 4,  4,  4,  4,  6,  6, 10, 12, 14, 16, 20, 26, 66},
+  { 4,  4,  4,  4,  6,  8, 12, 16, 20, 26, 34, 42, 12},
+  { 4,  4,  4,  6,  6,  8, 10, 14, 18, 26, 32, 42, 18},
+  { 4,  4,  4,  6,  8, 10, 12, 14, 18, 24, 32, 44, 12},
+  { 4,  4,  4,  6,  8, 10, 12, 14, 18, 24, 30, 40, 18},
+  { 4,  4,  4,  6,  8, 10, 12, 14, 18, 24, 30, 40, 18},
+  { 4,  4,  4,  6,  8, 10, 12, 14, 18, 24, 30, 40, 18},
+  { 8,  8,  8, 12, 16, 20, 24, 28, 36,  2,  2,  2, 26},
+};
+
+static const uint8_t mp3Pretab[22] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 3, 3, 3, 2, 0};
+
+static const uint8_t mp3Slen[2][16] = {
+  {0, 0, 0, 0, 3, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4},
+  {0, 1, 2, 3, 0, 1, 2, 3, 1, 2, 3, 1, 2, 3, 2, 3},
+};
+
+//ISO/IEC 13818-3 Table B.1: number of scalefactor bands per slen group
+//[table][long, short, mixed][group]
+static const uint8_t mp3ScalefactorBands[6][3][4] = {
+  {{ 6,  5,  5, 5}, { 9,  9,  9, 9}, { 6,  9,  9, 9}},
+  {{ 6,  5,  7, 3}, { 9,  9, 12, 6}, { 6,  9, 12, 6}},
+  {{11, 10,  0, 0}, {18, 18,  0, 0}, {15, 18,  0, 0}},
+  {{ 7,  7,  7, 0}, {12, 12, 12, 0}, { 6, 15, 12, 0}},
+  {{ 6,  6,  6, 3}, {12,  9,  9, 6}, { 6, 12,  9, 6}},
+  {{ 8,  8,  5, 0}, {15, 12,  9, 0}, { 6, 18,  9, 0}},
+};
+
+//ISO/IEC 11172-3 Table 3-B.9: Layer III antialias coefficients
+static const double mp3Alias[8] = {-0.6, -0.535, -0.33, -0.185, -0.095, -0.041, -0.0142, -0.0037};
+
+//ISO/IEC 11172-3 Table 3-B.3: synthesis window D[0-256] in units of 1/65536
+//the remaining coefficients follow from D[512 - i] = -D[i] (D[i] when i is a multiple of 64)
+static const int32_t mp3SynthesisWindow[257] = {
+         0,     -1,     -1,     -1,     -1,     -1,     -1,     -2,
+        -2,     -2,     -2,     -3,     -3,     -4,     -4,     -5,
+        -5,     -6,     -7,     -7,     -8,     -9,    -10,    -11,
+       -13,    -14,    -16,    -17,    -19,    -21,    -24,    -26,
+       -29,    -31,    -35,    -38,    -41,    -45,    -49,    -53,
+       -58,    -63,    -68,    -73,    -79,    -85,    -91,    -97,
+      -104,   -111,   -117,   -125,   -132,   -139,   -147,   -154,
+      -161,   -169,   -176,   -183,   -190,   -196,   -202,   -208,
+       213,    218,    222,    225,    227,    228,    228,    227,
+       224,    221,    215,    208,    200,    189,    177,    163,
+       146,    127,    106,     83,     57,     29,     -2,    -36,
+       -72,   -111,   -153,   -197,   -244,   -294,   -347,   -401,
+      -459,   -519,   -581,   -645,   -711,   -779,   -848,   -919,
+      -991,  -1064,  -1137,  -1210,  -1283,  -1356,  -1428,  -1498,
+     -1567,  -1634,  -1698,  -1759,  -1817,  -1870,  -1919,  -1962,
+     -2001,  -2032,  -2057,  -2075,  -2085,  -2087,  -2080,  -2063,
+      2037,   2000,   1952,   1893,   1822,   1739,   1644,   1535,
+      1414,   1280,   1131,    970,    794,    605,    402,    185,
+       -45,   -288,   -545,   -814,  -1095,  -1388,  -1692,  -2006,
+     -2330,  -2663,  -3004,  -3351,  -3705,  -4063,  -4425,  -4788,
+     -5153,  -5517,  -5879,  -6237,  -6589,  -6935,  -7271,  -7597,
+     -7910,  -8209,  -8491,  -8755,  -8998,  -9219,  -9416,  -9585,
+     -9727,  -9838,  -9916,  -9959,  -9966,  -9935,  -9863,  -9750,
+     -9592,  -9389,  -9139,  -8840,  -8492,  -8092,  -7640,  -7134,
+      6574,   5959,   5288,   4561,   3776,   2935,   2037,   1082,
+        70,   -998,  -2122,  -3300,  -4533,  -5818,  -7154,  -8540,
+     -9975, -11455, -12980, -14548, -16155, -17799, -19478, -21189,
+    -22929, -24694, -26482, -28289, -30112, -31947, -33791, -35640,
+    -37489, -39336, -41176, -43006, -44821, -46617, -48390, -50137,
+    -51853, -53534, -55178, -56778, -58333, -59838, -61289, -62684,
+    -64019, -65290, -66494, -67629, -68692, -69679, -70590, -71420,
+    -72169, -72835, -73415, -73908, -74313, -74630, -74856, -74992,
+     75038,
+};
+
+MP3::Tables::Tables() {
+  for(uint n : range(8207)) power[n] = pow(n, 4.0 / 3.0);
+
+  uint nodes = 0;
+  uint offset = 0;
+  for(uint table : range(16)) {
+    uint entries = mp3HuffmanSize[table] * mp3HuffmanSize[table];
+    treeRoot[table] = nodes;
+    tree[nodes][0] = tree[nodes][1] = 0;
+    nodes++;
+    for(uint index : range(entries)) {
+      uint length = mp3HuffmanLength[offset + index];
+      uint code = mp3HuffmanCode[offset + index];
+      uint node = treeRoot[table];
+      uint symbol = table < 15 ? (index / mp3HuffmanSize[table]) << 4 | index % mp3HuffmanSize[table] : index;
+      for(int bit = length - 1; bit >= 0; bit--) {
+        uint direction = code >> bit & 1;
+        if(bit == 0) {
+          tree[node][direction] = -1 - (int)symbol;
+        } else {
+          if(tree[node][direction] <= 0) {
+            tree[nodes][0] = tree[nodes][1] = 0;
+            tree[node][direction] = nodes++;
+          }
+          node = tree[node][direction];
+        }
+      }
+    }
+    offset += entries;
+  }
+
+  for(uint sampleRate : range(9)) {
+    longBand[sampleRate][0] = 0;
+    for(uint sfb : range(22)) longBand[sampleRate][sfb + 1] = longBand[sampleRate][sfb] + mp3LongBandWidth[sampleRate][sfb];
+    shortBand[sampleRate][0] = 0;
+    for(uint sfb : range(13)) shortBand[sampleRate][sfb + 1] = shortBand[sampleRate][sfb] + mp3ShortBandWidth[sampleRate][sfb];
+  }
+
+  for(uint n : range(36)) {
+    window[0][n] = sin(Math::Pi / 36 * (n + 0.5));
+    window[1][n] = n < 18 ? window[0][n] : n < 24 ? 1.0 : n < 30 ? sin(Math::Pi / 12 * (n - 18 + 0.5)) : 0.0;
+    window[2][n] = n < 12 ? sin(Math::Pi / 12 * (n + 0.5)) : 0.0;
+    window[3][n] = n < 6 ? 0.0 : n < 12 ? sin(Math::Pi / 12 * (n - 6 + 0.5)) : n < 18 ? 1.0 : window[0][n];
+  }
+
+  for(uint n : range(8)) {
+    double c = mp3Alias[n];
+    aliasS[n] = 1.0 / sqrt(1.0 + c * c);
+    aliasA[n] = c / sqrt(1.0 + c * c);
+  }
+
+  for(uint n : range(9)) {
+    dct18[0][n][0] = cos(Math::Pi * n / 18);
+    dct18[0][n][1] = sin(Math::Pi * n / 18);
+    dct18[1][n][0] = cos(Math::Pi * (4 * n + 1) / 72);
+    dct18[1][n][1] = sin(Math::Pi * (4 * n + 1) / 72);
+  }
+  for(uint n : range(3)) {
+    dct6[0][n][0] = cos(Math::Pi * n / 6);
+    dct6[0][n][1] = sin(Math::Pi * n / 6);
+    dct6[1][n][0] = cos(Math::Pi * (4 * n + 1) / 24);
+    dct6[1][n][1] = sin(Math::Pi * (4 * n + 1) / 24);
+  }
+  for(uint n : range(3)) {
+    for(uint k : range(3)) {
+      dft9[n][k][0] = cos(2 * Math::Pi * n * k / 9);
+      dft9[n][k][1] = sin(2 * Math::Pi * n * k / 9);
+    }
+  }
+
+  double* twiddle = dct32;
+  for(uint size = 32; size > 1; size >>= 1) {
+    for(uint n : range(size / 2)) *twiddle++ = 0.5 / cos(Math::Pi * (2 * n + 1) / (2 * size));
+  }
+
+  for(uint n : range(257)) {
+    double value = mp3SynthesisWindow[n] / 65536.0;
+    synthesisWindow[n] = value;
+    if(n & 63) value = -value;
+    if(n) synthesisWindow[512 - n] = value;
+  }
+
+  for(uint n : range(7)) {
+    if(n == 6) {
+      intensityLeft[n] = 1.0;
+      intensityRight[n] = 0.0;
+    } else {
+      double ratio = tan(n * Math::Pi / 12);
+      intensityLeft[n] = ratio / (1.0 + ratio);
+      intensityRight[n] = 1.0 / (1.0 + ratio);
+    }
+  }
+}
+
+auto MP3::tables() -> const Tables& {
+  static const Tables instance;
+  return instance;
+}
+
+MP3::MP3(const uint8_t* data, uint size) {
+  input = data;
+  inputSize = size;
+  memory::fill(channel, sizeof(channel));
+  tables();
+
+  //skip ID3v2 tag
+  if(size >= 10 && data[0] == 'I' && data[1] == 'D' && data[2] == '3') {
+    inputOffset = 10 + ((data[6] & 0x7f) << 21 | (data[7] & 0x7f) << 14 | (data[8] & 0x7f) << 7 | (data[9] & 0x7f));
+    if(data[5] & 0x10) inputOffset += 10;  //footer
+  }
+
+  if(!synchronize()) return;
+  channels = header.channels;
+  frequency = header.frequency;
+  if(parseXing(input + inputOffset)) inputOffset += header.length;
+  refill();
+}
+
+MP3::MP3(const vector<uint8_t>& data) : MP3(data.data(), data.size()) {
+}
+
+auto MP3::sample() -> array<double, 2> {
+  if(pcmOffset >= pcmSize) return {};
+
+  array<double, 2> sample;
+  sample[0] = pcm[pcmOffset][0];
+  sample[1] = pcm[pcmOffset][1];
+  if(++pcmOffset >= pcmSize) refill();
+  return sample;
+}
+
+MP3::operator bool() const {
+  return pcmOffset < pcmSize;
+}
+
+auto MP3::parseHeader(const uint8_t* data, Header& header) const -> bool {
+  static const uint bitrates[2][16] = {
+    {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0},
+    {0,  8, 16, 24, 32, 40, 48, 56,  64,  80,  96, 112, 128, 144, 160, 0},
+  };
+  static const uint frequencies[9] = {44100, 48000, 32000, 22050, 24000, 16000, 11025, 12000, 8000};
+
+  if(data[0] != 0xff || (data[1] & 0xe0) != 0xe0) return false;
+  uint version = data[1] >> 3 & 3;  //0 = MPEG-2.5, 2 = MPEG-2, 3 = MPEG-1
+  uint layer = data[1] >> 1 & 3;
+  uint bitrate = data[2] >> 4;
+  uint frequency = data[2] >> 2 & 3;
+  if(version == 1 || layer != 1 || bitrate == 0 || bitrate == 15 || frequency == 3) return false;
+
+  header.lsf = version != 3;
+  header.crc = !(data[1] & 1);
+  header.bitrate = bitrates[header.lsf][bitrate] * 1000;
+  header.sampleRate = (version == 3 ? 0 : version == 2 ? 3 : 6) + frequency;
+  header.frequency = frequencies[header.sampleRate];
+  header.mode = data[3] >> 6;
+  header.modeExtension = data[3] >> 4 & 3;
+  header.channels = header.mode == Mode::Mono ? 1 : 2;
+  header.length = (header.lsf ? 72 : 144) * header.bitrate / header.frequency + (data[2] >> 1 & 1);
+  return true;
+}
+
+//locate the next frame header; when searching, require the following frame to be valid as well
+auto MP3::synchronize() -> bool {
+  if(inputOffset + 4 <= inputSize && parseHeader(input + inputOffset, header)) {
+    if(inputOffset + header.length <= inputSize) return true;
+  }
+
+  while(inputOffset + 4 <= inputSize) {
+    if(parseHeader(input + inputOffset, header) && inputOffset + header.length <= inputSize) {
+      Header next;
+      uint nextOffset = inputOffset + header.length;
+      if(nextOffset + 4 > inputSize) return true;
+      if(parseHeader(input + nextOffset, next) && next.frequency == header.frequency) {
+        parseHeader(input + inputOffset, header);
+        return true;
+      }
+    }
+    inputOffset++;
+  }
+  return false;
+}
+
+//the first frame may carry a Xing/Info header (and LAME tag) rather than audio
+auto MP3::parseXing(const uint8_t* data) -> bool {
+  uint offset = 4 + (header.crc ? 2 : 0) + (header.lsf ? (header.channels == 1 ? 9 : 17) : (header.channels == 1 ? 17 : 32));
+  if(offset + 8 > header.length) return false;
+  const uint8_t* p = data + offset;
+  const uint8_t* end = data + header.length;
+  if(memory::compare(p, "Xing", 4) && memory::compare(p, "Info", 4)) return false;
+
+  uint flags = memory::readm<4>(p + 4);
+  p += 8;
+  uint frames = 0;
+  if(flags & 1) { if(p + 4 > end) return true; frames = memory::readm<4>(p); p += 4; }
+  if(flags & 2) p += 4;    //stream size
+  if(flags & 4) p += 100;  //seek table
+  if(flags & 8) p += 4;    //quality
+
+  if(p + 24 <= end && (
+     !memory::compare(p, "LAME", 4) || !memory::compare(p, "Lavf", 4) || !memory::compare(p, "Lavc", 4)
+  )) {
+    uint delay = p[21] << 4 | p[22] >> 4;
+    uint padding = (p[22] & 15) << 8 | p[23];
+    uint samples = (uint64_t)frames * (header.lsf ? 576 : 1152);
+    skip = delay + 529;  //529 samples of decoder delay
+    if(frames && samples > delay + padding) remaining = samples - delay - padding;
+  }
+  return true;
+}
+
+auto MP3::refill() -> void {
+  pcmOffset = pcmSize = 0;
+  while(remaining) {
+    if(!decodeFrame()) return;
+    if(skip) {
+      uint count = min(skip, pcmSize);
+      pcmOffset = count;
+      skip -= count;
+    }
+    if(pcmSize - pcmOffset > remaining) pcmSize = pcmOffset + remaining;
+    remaining -= pcmSize - pcmOffset;
+    if(pcmOffset < pcmSize) return;
+  }
+  pcmOffset = pcmSize = 0;
+}
+
+auto MP3::decodeFrame() -> bool {
+  if(!synchronize()) return false;
+  if(header.frequency != frequency) return false;
+
+  const uint8_t* frame = input + inputOffset;
+  inputOffset += header.length;
+
+  uint sideOffset = 4 + (header.crc ? 2 : 0);
+  uint sideSize = header.lsf ? (header.channels == 1 ? 9 : 17) : (header.channels == 1 ? 17 : 32);
+  if(sideOffset + sideSize > header.length) return false;
+
+  bitData = frame + sideOffset;
+  bitPosition = 0;
+  bitLength = sideSize * 8;
+  bool valid = readSideInformation();
+
+  //append main data to the bit reservoir; main_data_begin can reach back at most 511 bytes
+  uint payloadSize = header.length - sideOffset - sideSize;
+  uint keep = min(reservoirSize, 511u);
+  memory::move(reservoir, reservoir + reservoirSize - keep, keep);
+  memory::copy(reservoir + keep, frame + sideOffset + sideSize, payloadSize);
+  reservoirSize = keep + payloadSize;
+
+  uint granules = header.lsf ? 1 : 2;
+  pcmOffset = 0;
+  pcmSize = granules * 576;
+
+  if(!valid || mainDataBegin > keep) {
+    //missing reservoir data (stream starts mid-way, or corruption): output silence for this frame
+    memory::fill(pcm, sizeof(pcm));
+    return true;
+  }
+
+  bitData = reservoir;
+  bitPosition = (keep - mainDataBegin) * 8;
+  bitLength = reservoirSize * 8;
+
+  for(uint gr : range(granules)) {
+    for(uint ch : range(header.channels)) {
+      uint part2Start = bitPosition;
+      if(header.lsf) readScalefactorsLSF(ch);
+      else readScalefactors(gr, ch);
+      uint part3End = part2Start + granule[gr][ch].part23Length;
+      readHuffman(gr, ch, part3End);
+      bitPosition = part3End;
+      requantize(gr, ch);
+    }
+
+    if(header.channels == 2) stereo(gr);
+
+    for(uint ch : range(header.channels)) {
+      reorder(gr, ch);
+      antialias(gr, ch);
+      hybridSynthesis(gr, ch);
+      polyphaseSynthesis(gr, ch);
+    }
+  }
+
+  if(header.channels == 1) {
+    for(uint n : range(pcmSize)) pcm[n][1] = pcm[n][0];
+  }
+  return true;
+}
+
+auto MP3::readSideInformation() -> bool {
+  uint channels = header.channels;
+  mainDataBegin = bits(header.lsf ? 8 : 9);
+  bits(header.lsf ? (channels == 1 ? 1 : 2) : (channels == 1 ? 5 : 3));  //private bits
+  if(!header.lsf) for(uint ch : range(channels)) scfsi[ch] = bits(4);
+
+  for(uint gr : range(header.lsf ? 1 : 2)) {
+    for(uint ch : range(channels)) {
+      auto& g = granule[gr][ch];
+      g.part23Length = bits(12);
+      g.bigValues = bits(9);
+      g.globalGain = bits(8);
+      g.scalefacCompress = bits(header.lsf ? 9 : 4);
+      g.windowSwitching = bits(1);
+      if(g.windowSwitching) {
+        g.blockType = bits(2);
+        g.mixedBlock = bits(1);
+        g.tableSelect[0] = bits(5);
+        g.tableSelect[1] = bits(5);
+        g.tableSelect[2] = 0;
+        for(uint w : range(3)) g.subblockGain[w] = bits(3);
+        g.region0Count = 0;
+        g.region1Count = 0;
+        if(g.blockType == 0) return false;
+      } else {
+        g.blockType = 0;
+        g.mixedBlock = false;
+        for(uint r : range(3)) g.tableSelect[r] = bits(5);
+        for(uint w : range(3)) g.subblockGain[w] = 0;
+        g.region0Count = bits(4);
+        g.region1Count = bits(3);
+      }
+      g.preflag = header.lsf ? false : bits(1);
+      g.scalefacScale = bits(1);
+      g.count1Table = bits(1);
+      if(g.bigValues > 288) return false;
+    }
+  }
+  return true;
+}
+
+auto MP3::readScalefactors(uint gr, uint ch) -> void {
+  auto& g = granule[gr][ch];
+  auto& c = channel[ch];
+  uint slen1 = mp3Slen[0][g.scalefacCompress];
+  uint slen2 = mp3Slen[1][g.scalefacCompress];
+
+  if(g.windowSwitching && g.blockType == 2) {
+    uint sfb = 0;
+    if(g.mixedBlock) {
+      for(; sfb < 8; sfb++) c.scalefacLong[sfb] = bits(slen1);
+      sfb = 3;
+    }
+    for(; sfb < 12; sfb++) {
+      for(uint w : range(3)) c.scalefacShort[sfb][w] = bits(sfb < 6 ? slen1 : slen2);
+    }
+    for(uint w : range(3)) c.scalefacShort[12][w] = 0;
+  } else {
+    static const uint groups[5] = {0, 6, 11, 16, 21};
+    for(uint group : range(4)) {
+      if(gr == 1 && scfsi[ch] & (8 >> group)) continue;  //reuse scalefactors from granule 0
+      for(uint sfb : range(groups[group], groups[group + 1])) {
+        c.scalefacLong[sfb] = bits(group < 2 ? slen1 : slen2);
+      }
+    }
+    c.scalefacLong[21] = 0;
+  }
+}
+
+auto MP3::readScalefactorsLSF(uint ch) -> void {
+  auto& g = granule[0][ch];
+  auto& c = channel[ch];
+  uint sfc = g.scalefacCompress;
+  uint slen[4] = {0, 0, 0, 0};
+  uint table = 0;
+
+  if(ch == 1 && header.mode == Mode::JointStereo && header.modeExtension & 1) {
+    c.intensityScale = sfc & 1;
+    sfc >>= 1;
+    if(sfc < 180) {
+      slen[0] = sfc / 36; slen[1] = sfc % 36 / 6; slen[2] = sfc % 6; table = 3;
+    } else if(sfc < 244) {
+      sfc -= 180;
+      slen[0] = (sfc & 63) >> 4; slen[1] = (sfc & 15) >> 2; slen[2] = sfc & 3; table = 4;
+    } else {
+      sfc -= 244;
+      slen[0] = sfc / 3; slen[1] = sfc % 3; table = 5;
+    }
+  } else {
+    if(sfc < 400) {
+      slen[0] = (sfc >> 4) / 5; slen[1] = (sfc >> 4) % 5; slen[2] = (sfc & 15) >> 2; slen[3] = sfc & 3; table = 0;
+    } else if(sfc < 500) {
+      sfc -= 400;
+      slen[0] = (sfc >> 2) / 5; slen[1] = (sfc >> 2) % 5; slen[2] = sfc & 3; table = 1;
+    } else {
+      sfc -= 500;
+      slen[0] = sfc / 3; slen[1] = sfc % 3; table = 2;
+      g.preflag = true;
+    }
+  }
+
+  uint blockIndex = g.windowSwitching && g.blockType == 2 ? (g.mixedBlock ? 2 : 1) : 0;
+  uint index = 0;
+  for(uint group : range(4)) {
+    uint illegal = (1 << slen[group]) - 1;
+    for(uint bands = mp3ScalefactorBands[table][blockIndex][group]; bands; bands--) {
+      uint value = bits(slen[group]);
+      if(blockIndex == 0) {
+        c.scalefacLong[index] = value;
+        c.illegalLong[index] = illegal;
+      } else if(blockIndex == 2 && index < 6) {
+        c.scalefacLong[index] = value;
+        c.illegalLong[index] = illegal;
+      } else {
+        uint position = blockIndex == 2 ? index - 6 + 9 : index;
+        c.scalefacShort[position / 3][position % 3] = value;
+        c.illegalShort[position / 3] = illegal;
+      }
+      index++;
+    }
+  }
+
+  c.scalefacLong[21] = 0;
+  c.illegalLong[21] = c.illegalLong[20];
+  for(uint w : range(3)) c.scalefacShort[12][w] = 0;
+  c.illegalShort[12] = c.illegalShort[11];
+}
+
+auto MP3::readHuffman(uint gr, uint ch, uint part3End) -> void {
+  auto& g = granule[gr][ch];
+  auto& c = channel[ch];
+  auto& t = tables();
+
+  uint bigEnd = g.bigValues * 2;
+  uint region1, region2;
+  if(g.windowSwitching) {
+    if(g.blockType == 2) region1 = header.sampleRate == 8 ? 72 : 36;
+    else region1 = header.sampleRate <= 2 ? 36 : header.sampleRate != 8 ? 54 : 108;
+    region2 = 576;
+  } else {
+    region1 = t.longBand[header.sampleRate][min(g.region0Count + 1, 22u)];
+    region2 = t.longBand[header.sampleRate][min(g.region0Count + g.region1Count + 2, 22u)];
+  }
+  region1 = min(region1, bigEnd);
+  region2 = min(region2, bigEnd);
+
+  uint i = 0;
+  while(i < bigEnd) {
+    uint region = i < region1 ? 0 : i < region2 ? 1 : 2;
+    uint end = region == 0 ? region1 : region == 1 ? region2 : bigEnd;
+    int table = mp3HuffmanTable[g.tableSelect[region]];
+    uint linbits = mp3Linbits[g.tableSelect[region]];
+    if(table < 0) {
+      for(; i < end; i++) c.quantized[i] = 0;
+      continue;
+    }
+    for(; i < end; i += 2) {
+      uint symbol = huffman(table);
+      int x = symbol >> 4;
+      int y = symbol & 15;
+      if(x == 15 && linbits) x += bits(linbits);
+      if(x && bit()) x = -x;
+      if(y == 15 && linbits) y += bits(linbits);
+      if(y && bit()) y = -y;
+      c.quantized[i + 0] = x;
+      c.quantized[i + 1] = y;
+    }
+  }
+
+  while(i + 4 <= 576 && bitPosition < part3End) {
+    uint symbol = g.count1Table ? ~bits(4) & 15 : huffman(15);
+    int value[4];
+    for(uint n : range(4)) {
+      value[n] = symbol >> (3 - n) & 1;
+      if(value[n] && bit()) value[n] = -1;
+    }
+    if(bitPosition > part3End) break;  //the final codeword overran part2_3_length; discard it
+    for(uint n : range(4)) c.quantized[i++] = value[n];
+  }
+
+  c.nonzero = i;
+  for(; i < 576; i++) c.quantized[i] = 0;
+}
+
+auto MP3::requantize(uint gr, uint ch) -> void {
+  auto& g = granule[gr][ch];
+  auto& c = channel[ch];
+  auto& t = tables();
+  auto& longBand = t.longBand[header.sampleRate];
+  auto& shortBand = t.shortBand[header.sampleRate];
+
+  double gain = 0.25 * ((int)g.globalGain - 210);
+  double multiplier = g.scalefacScale ? 1.0 : 0.5;
+
+  auto scale = [&](uint start, uint end, double exponent) {
+    double factor = exp2(exponent);
+    for(uint i : range(start, min(end, c.nonzero))) {
+      int value = c.quantized[i];
+      double magnitude = t.power[min(value < 0 ? -value : value, 8206)] * factor;
+      c.spectrum[i] = value < 0 ? -magnitude : magnitude;
+    }
+  };
+
+  uint longBands = 22;
+  if(g.windowSwitching && g.blockType == 2) longBands = g.mixedBlock ? (header.lsf ? 6 : 8) : 0;
+  for(uint sfb : range(longBands)) {
+    uint pretab = g.preflag ? mp3Pretab[sfb] : 0;
+    scale(longBand[sfb], longBand[sfb + 1], gain - multiplier * (c.scalefacLong[sfb] + pretab));
+  }
+
+  if(longBands < 22) {
+    for(uint sfb : range(g.mixedBlock ? 3 : 0, 13)) {
+      uint width = shortBand[sfb + 1] - shortBand[sfb];
+      for(uint w : range(3)) {
+        uint start = shortBand[sfb] * 3 + w * width;
+        scale(start, start + width, gain - 2.0 * g.subblockGain[w] - multiplier * c.scalefacShort[sfb][w]);
+      }
+    }
+  }
+
+  for(uint i : range(c.nonzero, 576)) c.spectrum[i] = 0.0;
+}
+
+auto MP3::stereo(uint gr) -> void {
+  auto& left = channel[0];
+  auto& right = channel[1];
+  auto& g = granule[gr][1];
+  auto& t = tables();
+  auto& longBand = t.longBand[header.sampleRate];
+  auto& shortBand = t.shortBand[header.sampleRate];
+
+  bool midSide = header.mode == Mode::JointStereo && header.modeExtension & 2;
+  bool intensity = header.mode == Mode::JointStereo && header.modeExtension & 1;
+  uint limit = max(left.nonzero, right.nonzero);
+
+  auto applyMidSide = [&](uint start, uint end) {
+    if(!midSide) return;
+    for(uint i : range(start, end)) {
+      double m = left.spectrum[i];
+      double s = right.spectrum[i];
+      left.spectrum[i] = (m + s) * 0.707106781186547524;
+      right.spectrum[i] = (m - s) * 0.707106781186547524;
+    }
+  };
+
+  auto applyIntensity = [&](uint start, uint end, uint position, uint illegal) {
+    if(position == illegal) return applyMidSide(start, end);
+    double kl = 1.0, kr = 1.0;
+    if(!header.lsf) {
+      kl = t.intensityLeft[position];
+      kr = t.intensityRight[position];
+    } else if(position) {
+      double io = right.intensityScale ? 0.707106781186547524 : 0.840896415253714543;  //2^-0.25
+      if(position & 1) kl = pow(io, (position + 1) >> 1);
+      else kr = pow(io, position >> 1);
+    }
+    for(uint i : range(start, end)) {
+      double value = left.spectrum[i];
+      left.spectrum[i] = value * kl;
+      right.spectrum[i] = value * kr;
+    }
+  };
+
+  auto zero = [&](uint start, uint end) -> bool {
+    for(uint i : range(start, min(end, right.nonzero))) {
+      if(right.quantized[i]) return false;
+    }
+    return true;
+  };
+
+  if(!intensity) {
+    applyMidSide(0, limit);
+    left.nonzero = right.nonzero = limit;
+    return;
+  }
+
+  if(g.windowSwitching && g.blockType == 2) {
+    uint firstShort = g.mixedBlock ? 3 : 0;
+    int lastShort[3] = {-1, -1, -1};
+    for(uint sfb : range(firstShort, 13)) {
+      uint width = shortBand[sfb + 1] - shortBand[sfb];
+      for(uint w : range(3)) {
+        uint start = shortBand[sfb] * 3 + w * width;
+        if(!zero(start, start + width)) lastShort[w] = sfb;
+      }
+    }
+
+    if(g.mixedBlock) {
+      uint longBands = header.lsf ? 6 : 8;
+      if(lastShort[0] >= 0 || lastShort[1] >= 0 || lastShort[2] >= 0) {
+        applyMidSide(0, longBand[longBands]);
+      } else {
+        int lastLong = -1;
+        for(uint sfb : range(longBands)) if(!zero(longBand[sfb], longBand[sfb + 1])) lastLong = sfb;
+        for(uint sfb : range(longBands)) {
+          if((int)sfb <= lastLong) applyMidSide(longBand[sfb], longBand[sfb + 1]);
+          else applyIntensity(longBand[sfb], longBand[sfb + 1], right.scalefacLong[sfb], header.lsf ? right.illegalLong[sfb] : 7);
+        }
+      }
+    }
+
+    for(uint sfb : range(firstShort, 13)) {
+      uint width = shortBand[sfb + 1] - shortBand[sfb];
+      uint source = min(sfb, 11u);
+      for(uint w : range(3)) {
+        uint start = shortBand[sfb] * 3 + w * width;
+        if((int)sfb <= lastShort[w]) applyMidSide(start, start + width);
+        else applyIntensity(start, start + width, right.scalefacShort[source][w], header.lsf ? right.illegalShort[source] : 7);
+      }
+    }
+  } else {
+    int lastLong = -1;
+    for(uint sfb : range(22)) if(!zero(longBand[sfb], longBand[sfb + 1])) lastLong = sfb;
+    for(uint sfb : range(22)) {
+      uint source = min(sfb, 20u);
+      if((int)sfb <= lastLong) applyMidSide(longBand[sfb], longBand[sfb + 1]);
+      else applyIntensity(longBand[sfb], longBand[sfb + 1], right.scalefacLong[source], header.lsf ? right.illegalLong[source] : 7);
+    }
+  }
+
+  left.nonzero = right.nonzero = max(limit, left.nonzero);
+}
+
+//interleave short block windows so that each subband holds its three windows side by side
+auto MP3::reorder(uint gr, uint ch) -> void {
+  auto& g = granule[gr][ch];
+  auto& c = channel[ch];
+  if(!g.windowSwitching || g.blockType != 2) return;
+  auto& shortBand = tables().shortBand[header.sampleRate];
+
+  double buffer[576];
+  for(uint sfb : range(g.mixedBlock ? 3 : 0, 13)) {
+    uint start = shortBand[sfb] * 3;
+    uint width = shortBand[sfb + 1] - shortBand[sfb];
+    for(uint w : range(3)) {
+      for(uint f : range(width)) buffer[f * 3 + w] = c.spectrum[start + w * width + f];
+    }
+    memory::copy(c.spectrum + start, buffer, width * 3 * sizeof(double));
+  }
+  c.nonzero = 576;
+}
+
+auto MP3::antialias(uint gr, uint ch) -> void {
+  auto& g = granule[gr][ch];
+  auto& c = channel[ch];
+  auto& t = tables();
+
+  uint limit;
+  if(g.windowSwitching && g.blockType == 2) {
+    if(!g.mixedBlock) return;
+    limit = 1;
+  } else {
+    limit = min((c.nonzero + 17) / 18, 31u);
+  }
+
+  for(uint sb : range(1, limit + 1)) {
+    double* lower = c.spectrum + sb * 18 - 1;
+    double* upper = c.spectrum + sb * 18;
+    for(uint i : range(8)) {
+      double a = lower[-(int)i];
+      double b = upper[i];
+      lower[-(int)i] = a * t.aliasS[i] - b * t.aliasA[i];
+      upper[i] = b * t.aliasS[i] + a * t.aliasA[i];
+    }
+  }
+  c.nonzero = max(c.nonzero, min((limit + 1) * 18, 576u));
+}
+
+auto MP3::hybridSynthesis(uint gr, uint ch) -> void {
+  auto& g = granule[gr][ch];
+  auto& c = channel[ch];
+  auto& t = tables();
+
+  for(uint sb : range(32)) {
+    double* overlap = c.overlap[sb];
+    uint blockType = g.windowSwitching && !(g.mixedBlock && sb < 2) ? g.blockType : 0;
+
+    if(sb * 18 >= c.nonzero) {
+      //all inputs are zero: only the previous granule's overlap remains
+      for(uint i : range(18)) {
+        time[i][sb] = overlap[i];
+        overlap[i] = 0.0;
+      }
+    } else if(blockType != 2) {
+      double output[36];
+      imdct(c.spectrum + sb * 18, 1, output, 18);
+      for(uint i : range(18)) {
+        time[i][sb] = output[i] * t.window[blockType][i] + overlap[i];
+        overlap[i] = output[i + 18] * t.window[blockType][i + 18];
+      }
+    } else {
+      double output[36] = {0};
+      for(uint w : range(3)) {
+        double block[12];
+        imdct(c.spectrum + sb * 18 + w, 3, block, 6);
+        for(uint i : range(12)) output[6 + w * 6 + i] += block[i] * t.window[2][i];
+      }
+      for(uint i : range(18)) {
+        time[i][sb] = output[i] + overlap[i];
+        overlap[i] = output[i + 18];
+      }
+    }
+
+    //frequency inversion
+    if(sb & 1) for(uint i : range(1, 18, 2)) time[i][sb] = -time[i][sb];
+  }
+}
+
+auto MP3::polyphaseSynthesis(uint gr, uint ch) -> void {
+  auto& c = channel[ch];
+  auto& t = tables();
+
+  for(uint slot : range(18)) {
+    //matrixing: V[i] = sum(S[k] * cos((16 + i) * (2k + 1) * pi / 64)), computed via a 32-point DCT-II
+    double x[32];
+    memory::copy(x, time[slot], sizeof(x));
+    dct(x, 32, t.dct32);
+
+    c.synthesisOffset = (c.synthesisOffset - 64) & 1023;
+    double* v = c.synthesis;
+    uint o = c.synthesisOffset;
+    for(uint i : range(16)) v[(o + i) & 1023] = x[i + 16];
+    v[(o + 16) & 1023] = 0.0;
+    for(uint i : range(17, 48)) v[(o + i) & 1023] = -x[48 - i];
+    for(uint i : range(48, 64)) v[(o + i) & 1023] = -x[i - 48];
+
+    double* output = &pcm[gr * 576 + slot * 32][0];
+    for(uint j : range(32)) {
+      double sum = 0.0;
+      for(uint i : range(8)) {
+        sum += v[(o + i * 128 + j     ) & 1023] * t.synthesisWindow[i * 64 + j];
+        sum += v[(o + i * 128 + j + 96) & 1023] * t.synthesisWindow[i * 64 + j + 32];
+      }
+      output[j * 2 + ch] = sum;
+    }
+  }
+}
+
+auto MP3::bit() -> uint {
+  if(bitPosition >= bitLength) { bitPosition++; return 0; }
+  uint result = bitData[bitPosition >> 3] >> (7 - (bitPosition & 7)) & 1;
+  bitPosition++;
+  return result;
+}
+
+auto MP3::bits(uint count) -> uint {
+  uint result = 0;
+  while(count--) result = result << 1 | bit();
+  return result;
+}
+
+auto MP3::huffman(uint table) -> uint {
+  auto& t = tables();
+  uint node = t.treeRoot[table];
+  while(true) {
+    int next = t.tree[node][bit()];
+    if(next < 0) return -1 - next;
+    if(next == 0) return 0;  //invalid code
+    node = next;
+  }
+}
+
+//in-place complex DFT for sizes 3 and 9 (radix-3)
+auto MP3::dft(double* re, double* im, uint size) -> void {
+  static const double s = 0.866025403784438647;  //sin(2pi/3)
+
+  auto dft3 = [&](double& r0, double& i0, double& r1, double& i1, double& r2, double& i2) {
+    double tr = r1 + r2, ti = i1 + i2;
+    double mr = r0 - 0.5 * tr, mi = i0 - 0.5 * ti;
+    double dr = s * (i1 - i2), di = -s * (r1 - r2);
+    r0 += tr; i0 += ti;
+    r1 = mr + dr; i1 = mi + di;
+    r2 = mr - dr; i2 = mi - di;
+  };
+
+  if(size == 3) return dft3(re[0], im[0], re[1], im[1], re[2], im[2]);
+
+  auto& t = tables();
+  double ar[3][3], ai[3][3];
+  for(uint n2 : range(3)) {
+    double r0 = re[n2], i0 = im[n2], r1 = re[n2 + 3], i1 = im[n2 + 3], r2 = re[n2 + 6], i2 = im[n2 + 6];
+    dft3(r0, i0, r1, i1, r2, i2);
+    double r[3] = {r0, r1, r2}, i[3] = {i0, i1, i2};
+    for(uint k1 : range(3)) {
+      double c = t.dft9[n2][k1][0], sn = t.dft9[n2][k1][1];
+      ar[n2][k1] = r[k1] * c + i[k1] * sn;
+      ai[n2][k1] = i[k1] * c - r[k1] * sn;
+    }
+  }
+  for(uint k1 : range(3)) {
+    double r0 = ar[0][k1], i0 = ai[0][k1], r1 = ar[1][k1], i1 = ai[1][k1], r2 = ar[2][k1], i2 = ai[2][k1];
+    dft3(r0, i0, r1, i1, r2, i2);
+    re[k1] = r0; im[k1] = i0;
+    re[k1 + 3] = r1; im[k1 + 3] = i1;
+    re[k1 + 6] = r2; im[k1 + 6] = i2;
+  }
+}
+
+//IMDCT of size inputs (18 or 6) to size * 2 outputs
+//computed as a DCT-IV via a size / 2 point complex DFT, then unfolded by symmetry
+auto MP3::imdct(const double* input, uint stride, double* output, uint size) -> void {
+  auto& t = tables();
+  const double (*pre)[2] = size == 18 ? t.dct18[0] : t.dct6[0];
+  const double (*post)[2] = size == 18 ? t.dct18[1] : t.dct6[1];
+  uint half = size / 2;
+
+  double re[9], im[9];
+  for(uint n : range(half)) {
+    double a = input[stride * (2 * n)];
+    double b = input[stride * (size - 1 - 2 * n)];
+    double c = pre[n][0], s = pre[n][1];
+    re[n] = a * c + b * s;
+    im[n] = b * c - a * s;
+  }
+
+  dft(re, im, half);
+
+  double y[18];
+  for(uint k : range(half)) {
+    double c = post[k][0], s = post[k][1];
+    y[2 * k] = re[k] * c + im[k] * s;
+    y[size - 1 - 2 * k] = re[k] * s - im[k] * c;
+  }
+
+  for(uint i : range(size * 2)) {
+    uint m = i + half;
+    output[i] = m < size ? y[m] : m < size * 2 ? -y[size * 2 - 1 - m] : -y[m - size * 2];
+  }
+}
+
+//fast DCT-II (Lee): X[k] = sum(x[n] * cos(pi * k * (2n + 1) / (2 * size)))
+auto MP3::dct(double* data, uint size, const double* twiddle) -> void {
+  if(size == 1) return;
+  uint half = size / 2;
+  double even[16], odd[16];
+  for(uint n : range(half)) {
+    even[n] = data[n] + data[size - 1 - n];
+    odd[n] = (data[n] - data[size - 1 - n]) * twiddle[n];
+  }
+  dct(even, half, twiddle + half);
+  dct(odd, half, twiddle + half);
+  for(uint n : range(half)) {
+    data[n * 2] = even[n];
+    data[n * 2 + 1] = odd[n] + (n + 1 < half ? odd[n + 1] : 0.0);
+  }
+}
+
+}
+
+}
@@ -5,7 +5,8 @@ namespace ramus {
 namespace Decode {
 
 struct Wave {
-  Wave(const vector<uint8_t>& data_);
+  Wave(const uint8_t* data, uint size);
+  Wave(const vector<uint8_t>& data);
 
   auto sample() -> array<double, 2>;
 
@@ -24,7 +25,6 @@ struct Wave {
   uint frequency;
 
 private:
-  vector<uint8_t> data;
   const uint8_t* pos;
 
   uint format;
@@ -32,20 +32,20 @@ private:
   uint remainingSamples;
 };
 
-Wave::Wave(const vector<uint8_t>& data_) {
-  data = data_;
-
-  const uint8_t* pos_ = data.data();
+//data is not copied, and must remain valid while samples are being read
+Wave::Wave(const uint8_t* data, uint size) {
+  const uint8_t* pos_ = data;
+  const uint8_t* end_ = data + size;
   remainingSamples = 0;
+  format = 0;
 
-  string header = "";
-  header.reserve(4);
+  const uint8_t* header;
 
   uint32_t byteRate;
-  uint16_t sampleSize;
+  uint16_t sampleSize = 0;
 
   auto readHeader = [&]() -> void {
-    memory::copy((uint8_t*)header.data(), pos_, 4);
+    header = pos_;
     pos_ += 4;
   };
 
@@ -54,27 +54,34 @@ Wave::Wave(const vector<uint8_t>& data_) {
   };
 
   auto read16 = [&]() -> uint16_t {
-    return read8() | read8() << 8;
+    uint16_t lo = read8();
+    return lo | read8() << 8;
   };
 
   auto read32 = [&]() -> uint32_t {
-    return read16() | read16() << 16;
+    uint32_t lo = read16();
+    return lo | read16() << 16;
   };
 
+  if(size < 12) return;
+
   readHeader();
-  if(header != "RIFF") return;
-  uint waveSize = read32();
+  if(memory::compare(header, "RIFF", 4)) return;
+  read32();  //RIFF size: the chunks are bounded by the data itself
 
   readHeader();
-  if(header != "WAVE") return;
+  if(memory::compare(header, "WAVE", 4)) return;
 
   uint chunkSize;
 
-  while(pos_ - data.data() < data.size()) {
+  while(end_ - pos_ >= 8) {
     readHeader();
     chunkSize = read32();
+    const uint8_t* next = pos_ + chunkSize + (chunkSize & 1);  //chunks are word-aligned
+    if(chunkSize > end_ - pos_) chunkSize = end_ - pos_;
 
-    if(header == "fmt ") {
+    if(!memory::compare(header, "fmt ", 4)) {
+      if(chunkSize < 16) return;
       format     = read16();
       channels   = read16();
       frequency  = read32();
@@ -82,21 +89,33 @@ Wave::Wave(const vector<uint8_t>& data_) {
       sampleSize = read16();
       bitDepth   = read16();
 
-      chunkSize -= 16;
-      if(chunkSize) return;
+      if(format == Format::EXTENSIBLE && chunkSize >= 26) {
+        pos_ += 8;
+        format = read16();  //first two bytes of the SubFormat GUID
+      }
 
+      if(!channels || !frequency) return;
       if(sampleSize != channels * (bitDepth >> 3)) return;
       if(byteRate   != frequency * sampleSize) return;
-    } else if(header == "data") {
+    } else if(!memory::compare(header, "data", 4)) {
       pos = pos_;
-      if(format == Format::PCM) remainingSamples = chunkSize / sampleSize;
-      pos_ += chunkSize;
-    } else if(header == "fact") {
-      if(format != Format::PCM) remainingSamples = read32();
-    } else {  //Ignore other chunks
-      while(chunkSize--) read8();
+      if(sampleSize) remainingSamples = chunkSize / sampleSize;
     }
+
+    if(next > end_) break;
+    pos_ = next;
   }
+
+  if(format == Format::PCM) {
+    if(bitDepth != 8 && bitDepth != 16 && bitDepth != 24 && bitDepth != 32) remainingSamples = 0;
+  } else if(format == Format::IEEE_FLOAT) {
+    if(bitDepth != 32) remainingSamples = 0;
+  } else {
+    remainingSamples = 0;
+  }
+}
+
+Wave::Wave(const vector<uint8_t>& data) : Wave(data.data(), data.size()) {
 }
 
 auto Wave::sample() -> array<double, 2> {
@@ -107,29 +126,34 @@ auto Wave::sample() -> array<double, 2> {
   };
 
   auto read16 = [&]() -> uint16_t {
-    return read8() | read8() << 8;
+    uint16_t lo = read8();
+    return lo | read8() << 8;
   };
 
   auto read32 = [&]() -> uint32_t {
-    return read16() | read16() << 16;
+    uint32_t lo = read16();
+    return lo | read16() << 16;
   };
 
   auto readFloat32 = [&]() -> float32_t {
     uint32_t raw = read32();
-    int significand = (raw & 0x007fffff) | 0x800000;
-    int exponent = ((raw & 0x7f800000) >> 23) - 127;
-    int sign = 1 - ((raw & 0x80000000) >> 30);
-    return sign * (significand / 8388608.0) * pow(2, exponent);
+    float32_t value;
+    memory::copy(&value, &raw, 4);
+    return value;
   };
 
   auto readSample = [&]() -> double {
     if(format == Format::PCM) {
-      return read16() / 32768.0;
+      switch(bitDepth) {
+      case  8: return (read8() - 128) / 128.0;
+      case 16: return (int16_t)read16() / 32768.0;
+      case 24: { uint32_t lo = read16(); return (int32_t)(lo << 8 | read8() << 24) / 2147483648.0; }
+      case 32: return (int32_t)read32() / 2147483648.0;
+      }
     } else if(format == Format::IEEE_FLOAT) {
       return readFloat32();
-    } else {
-      return 0.0;
     }
+    return 0.0;
   };
 
   remainingSamples--;
@@ -137,6 +161,7 @@ auto Wave::sample() -> array<double, 2> {
   array<double, 2> sample;
   sample[0] = readSample();
   sample[1] = channels > 1 ? readSample() : sample[0];
+  for(uint n = 2; n < channels; n++) readSample();
   return sample;
 }
 
@@ -0,0 +1,191 @@
+#pragma once
+
+//locates a loop start for tracks without loop metadata
+//the final second of the track is matched against the preceding audio by normalized
+//cross-correlation; if it repeats earlier material, the loop starts right after that match
+//(e.g. a track ripped as intro, loop, loop loops back to the start of the second iteration)
+
+//only the most recent search window is retained, so memory use is bounded per track
+//a coarse FFT correlation over a decimated signal is refined at the full sampling rate
+
+#include <nall/maybe.hpp>
+#include <nall/vector.hpp>
+
+namespace ramus { namespace DSP {
+
+using namespace nall;
+
+struct LoopFinder {
+  inline auto reset(uint frequency, double searchLength = 120.0, double matchLength = 1.0) -> void;
+  inline auto write(double left, double right) -> void;
+  inline auto find(double threshold = 0.97) -> maybe<uint>;
+
+private:
+  enum : uint { Decimation = 16, Candidates = 16, Refinement = Decimation };
+
+  static inline auto fft(double* re, double* im, uint size, bool inverse) -> void;
+  inline auto at(uint64_t position) const -> float;
+  inline auto correlate(uint64_t position) const -> double;
+
+  uint matchSize;
+  uint ringSize;
+  vector<float> ring;  //most recent ringSize mono samples
+  uint64_t count;
+  double matchEnergy;
+};
+
+auto LoopFinder::reset(uint frequency, double searchLength, double matchLength) -> void {
+  matchSize = max(1u, (uint)(frequency * matchLength) / Decimation) * Decimation;
+  ringSize = (uint)(frequency * searchLength) / Decimation * Decimation + matchSize;
+  ring.reset();
+  ring.resize(ringSize);
+  count = 0;
+}
+
+auto LoopFinder::write(double left, double right) -> void {
+  ring[count++ % ringSize] = (left + right) * 0.5;
+}
+
+auto LoopFinder::at(uint64_t position) const -> float {
+  return ring[position % ringSize];
+}
+
+//normalized cross-correlation between the match window (final matchSize samples) and the window at position
+auto LoopFinder::correlate(uint64_t position) const -> double {
+  uint64_t match = count - matchSize;
+  double product = 0.0, energy = 0.0;
+  for(uint n : range(matchSize)) {
+    double sample = at(position + n);
+    product += sample * at(match + n);
+    energy += sample * sample;
+  }
+  if(energy <= 0.0) return 0.0;
+  return product / sqrt(energy * matchEnergy);
+}
+
+auto LoopFinder::find(double threshold) -> maybe<uint> {
+  //the loop must span at least one match window, and the search cannot reach past retained audio
+  if(count < matchSize * 3) return nothing;
+  uint64_t first = count > ringSize ? count - ringSize : 0;
+  uint64_t last = count - matchSize * 2;  //latest candidate position
+  uint64_t match = count - matchSize;
+
+  matchEnergy = 0.0;
+  for(uint n : range(matchSize)) matchEnergy += at(match + n) * at(match + n);
+  if(matchEnergy < matchSize * 1e-8) return nothing;  //silent endings match everything
+
+  //coarse pass: decimated signal in the real part, decimated match window in the imaginary part
+  uint signalSize = (last - first) / Decimation + matchSize / Decimation;
+  uint patternSize = matchSize / Decimation;
+  uint size = 1;
+  while(size < signalSize + patternSize) size <<= 1;
+
+  auto decimate = [&](uint64_t position) -> double {
+    double sum = 0.0;
+    for(uint n : range(Decimation)) sum += at(position + n);
+    return sum;
+  };
+  vector<double> decimated;
+  decimated.resize(signalSize);
+  for(uint n : range(signalSize)) decimated[n] = decimate(first + (uint64_t)n * Decimation);
+
+  vector<double> re, im;
+  re.resize(size);
+  im.resize(size);
+  for(uint n : range(size)) re[n] = im[n] = 0.0;
+  double patternEnergy = 0.0;
+  for(uint n : range(signalSize)) re[n] = decimated[n];
+  for(uint n : range(patternSize)) {
+    im[n] = decimate(match + (uint64_t)n * Decimation);
+    patternEnergy += im[n] * im[n];
+  }
+
+  fft(re.data(), im.data(), size, false);
+
+  //separate both spectra, then multiply the signal by the conjugate pattern spectrum
+  for(uint k = 0; k <= size / 2; k++) {
+    uint j = (size - k) & (size - 1);
+    double zr = re[k], zi = im[k], wr = re[j], wi = im[j];
+    double sr = (zr + wr) * 0.5, si = (zi - wi) * 0.5;  //signal
+    double pr = (zi + wi) * 0.5, pi = (wr - zr) * 0.5;  //pattern
+    re[k] = sr * pr + si * pi;
+    im[k] = si * pr - sr * pi;
+    re[j] = re[k];
+    im[j] = -im[k];
+  }
+
+  fft(re.data(), im.data(), size, true);
+
+  //normalize by the sliding window energy of the decimated signal
+  uint positions = signalSize - patternSize + 1;
+  vector<double> score;
+  score.resize(positions);
+  double energy = 0.0;
+  for(uint n : range(patternSize)) energy += decimated[n] * decimated[n];
+  for(uint n : range(positions)) {
+    score[n] = energy > 0.0 ? re[n] / size / sqrt(energy * patternEnergy) : 0.0;
+    if(n + patternSize < signalSize) {
+      energy += decimated[n + patternSize] * decimated[n + patternSize];
+      energy -= decimated[n] * decimated[n];
+      if(energy < 0.0) energy = 0.0;
+    }
+  }
+
+  //refine the strongest coarse local maxima at the full sampling rate
+  //decimation discards high frequency alignment, so coarse scores only nominate candidates
+  vector<uint> candidates;
+  for(uint n : range(positions)) {
+    if(score[n] < 0.5) continue;
+    if(n > 0 && score[n - 1] > score[n]) continue;
+    if(n + 1 < positions && score[n + 1] >= score[n]) continue;
+    candidates.append(n);
+  }
+  candidates.sort([&](uint x, uint y) { return score[x] > score[y]; });
+  if(candidates.size() > Candidates) candidates.resize(Candidates);
+
+  bool found = false;
+  uint64_t best = 0;
+  double bestScore = threshold;
+  for(uint candidate : candidates) {
+    uint64_t center = first + (uint64_t)candidate * Decimation;
+    uint64_t lower = center > first + Refinement ? center - Refinement : first;
+    uint64_t upper = min(center + Refinement, last);
+    for(uint64_t position = lower; position <= upper; position++) {
+      double value = correlate(position);
+      if(value >= bestScore) bestScore = value, best = position, found = true;
+    }
+  }
+
+  if(!found) return nothing;
+  return (uint)(best + matchSize);
+}
+
+//iterative radix-2 complex FFT; the inverse transform is unscaled
+auto LoopFinder::fft(double* re, double* im, uint size, bool inverse) -> void {
+  for(uint i = 1, j = 0; i < size; i++) {
+    uint bit = size >> 1;
+    for(; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if(i < j) swap(re[i], re[j]), swap(im[i], im[j]);
+  }
+
+  for(uint length = 2; length <= size; length <<= 1) {
+    double angle = 2 * Math::Pi / length * (inverse ? 1 : -1);
+    double wr = cos(angle), wi = sin(angle);
+    for(uint offset = 0; offset < size; offset += length) {
+      double cr = 1.0, ci = 0.0;
+      for(uint n : range(length / 2)) {
+        uint a = offset + n, b = a + length / 2;
+        double tr = re[b] * cr - im[b] * ci;
+        double ti = re[b] * ci + im[b] * cr;
+        re[b] = re[a] - tr; im[b] = im[a] - ti;
+        re[a] += tr; im[a] += ti;
+        double nr = cr * wr - ci * wi;
+        ci = cr * wi + ci * wr;
+        cr = nr;
+      }
+    }
+  }
+}
+
+}}
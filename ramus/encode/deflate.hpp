@@ -151,7 +151,7 @@ inline auto compress(const uint8_t* source, uint length) -> BitBuffer {
   };
 
   const uint8_t* end = source + length;
-  while(source < end - MIN_MATCH) {
+  while(end - source > MIN_MATCH) {
     const uint8_t** bucket = &hashtable[hash(source) & (HASH_SIZE - 1)];
     const uint8_t* subs = *bucket;
     *bucket = source;
@@ -1,6 +1,7 @@
 #pragma once
 
 //creates DEFLATE-compressed ZIP archives
+//ZIP64 records are written only for the fields and archives that exceed the 32-bit limits
 
 #include <nall/string.hpp>
 #include <nall/hash/crc32.hpp>
@@ -29,56 +30,95 @@ struct ZIP {
     auto compressed = ramus::Encode::deflate(data, size);
 
     directory.append({filename, checksum, compressed.size(), size, fp.offset()});
+    bool zip64 = compressed.size() >= 0xffffffff || size >= 0xffffffff;
 
     fp.writel(0x04034b50, 4);                        //signature
-    fp.writel(0x0014, 2);                            //minimum version (2.0)
+    fp.writel(zip64 ? 0x002d : 0x0014, 2);           //minimum version (4.5 for ZIP64, otherwise 2.0)
     fp.writel(0x0000, 2);                            //general purpose bit flags
     fp.writel(0x0008, 2);                            //compression method (8 = DEFLATE)
     fp.writel(dosTime, 2);
     fp.writel(dosDate, 2);
     fp.writel(checksum, 4);
-    fp.writel(compressed.size(), 4);                 //compressed size
-    fp.writel(size, 4);                              //uncompressed size
+    fp.writel(zip64 ? 0xffffffff : compressed.size(), 4);  //compressed size
+    fp.writel(zip64 ? 0xffffffff : size, 4);         //uncompressed size
     fp.writel(filename.length(), 2);                 //file name length
-    fp.writel(0x0000, 2);                            //extra field length
+    fp.writel(zip64 ? 20 : 0, 2);                    //extra field length
     fp.print(filename);                              //file name
+    if(zip64) {
+      fp.writel(0x0001, 2);                          //ZIP64 extended information
+      fp.writel(16, 2);
+      fp.writel(size, 8);
+      fp.writel(compressed.size(), 8);
+    }
 
     fp.write(compressed.data(), compressed.size());  //file data
   }
 
   ~ZIP() {
     //central directory
-    unsigned baseOffset = fp.offset();
+    uint64_t baseOffset = fp.offset();
     for(auto& entry : directory) {
+      uint64_t fields[3];
+      uint zip64 = 0;
+      if(entry.uncompressedSize >= 0xffffffff) fields[zip64++] = entry.uncompressedSize;
+      if(entry.compressedSize   >= 0xffffffff) fields[zip64++] = entry.compressedSize;
+      if(entry.offset           >= 0xffffffff) fields[zip64++] = entry.offset;
+
       fp.writel(0x02014b50, 4);               //signature
-      fp.writel(0x0014, 2);                   //version made by (2.0)
-      fp.writel(0x0014, 2);                   //version needed to extract (2.0)
+      fp.writel(zip64 ? 0x002d : 0x0014, 2);  //version made by (4.5 or 2.0)
+      fp.writel(zip64 ? 0x002d : 0x0014, 2);  //version needed to extract (4.5 or 2.0)
       fp.writel(0x0000, 2);                   //general purpose bit flags
       fp.writel(0x0008, 2);                   //compression method (8 = DEFLATE)
       fp.writel(dosTime, 2);
       fp.writel(dosDate, 2);
       fp.writel(entry.checksum, 4);
-      fp.writel(entry.compressedSize, 4);     //compressed size
-      fp.writel(entry.uncompressedSize, 4);   //uncompressed size
+      fp.writel(min(entry.compressedSize, 0xffffffff), 4);    //compressed size
+      fp.writel(min(entry.uncompressedSize, 0xffffffff), 4);  //uncompressed size
       fp.writel(entry.filename.length(), 2);  //file name length
-      fp.writel(0x0000, 2);                   //extra field length
+      fp.writel(zip64 ? 4 + zip64 * 8 : 0, 2);  //extra field length
       fp.writel(0x0000, 2);                   //file comment length
       fp.writel(0x0000, 2);                   //disk number start
       fp.writel(0x0000, 2);                   //internal file attributes
       fp.writel(0x00000000, 4);               //external file attributes
-      fp.writel(entry.offset, 4);             //relative offset of file header
+      fp.writel(min(entry.offset, 0xffffffff), 4);  //relative offset of file header
       fp.print(entry.filename);
+      if(zip64) {
+        fp.writel(0x0001, 2);                 //ZIP64 extended information
+        fp.writel(zip64 * 8, 2);
+        for(uint n : range(zip64)) fp.writel(fields[n], 8);
+      }
+    }
+    uint64_t finishOffset = fp.offset();
+    uint64_t directorySize = finishOffset - baseOffset;
+
+    if(directory.size() >= 0xffff || directorySize >= 0xffffffff || baseOffset >= 0xffffffff) {
+      //ZIP64 end of central directory record
+      fp.writel(0x06064b50, 4);               //signature
+      fp.writel(44, 8);                       //size of the remaining record
+      fp.writel(0x002d, 2);                   //version made by (4.5)
+      fp.writel(0x002d, 2);                   //version needed to extract (4.5)
+      fp.writel(0x00000000, 4);               //number of this disk
+      fp.writel(0x00000000, 4);               //disk where central directory starts
+      fp.writel(directory.size(), 8);         //number of central directory records on this disk
+      fp.writel(directory.size(), 8);         //total number of central directory records
+      fp.writel(directorySize, 8);            //size of central directory
+      fp.writel(baseOffset, 8);               //offset of central directory
+
+      //ZIP64 end of central directory locator
+      fp.writel(0x07064b50, 4);               //signature
+      fp.writel(0x00000000, 4);               //disk where ZIP64 end of central directory record starts
+      fp.writel(finishOffset, 8);             //offset of ZIP64 end of central directory record
+      fp.writel(0x00000001, 4);               //total number of disks
     }
-    unsigned finishOffset = fp.offset();
 
     //end of central directory
     fp.writel(0x06054b50, 4);                 //signature
     fp.writel(0x0000, 2);                     //number of this disk
     fp.writel(0x0000, 2);                     //disk where central directory starts
-    fp.writel(directory.size(), 2);           //number of central directory records on this disk
-    fp.writel(directory.size(), 2);           //total number of central directory records
-    fp.writel(finishOffset - baseOffset, 4);  //size of central directory
-    fp.writel(baseOffset, 4);                 //offset of central directory
+    fp.writel(min(directory.size(), 0xffff), 2);  //number of central directory records on this disk
+    fp.writel(min(directory.size(), 0xffff), 2);  //total number of central directory records
+    fp.writel(min(directorySize, 0xffffffff), 4);  //size of central directory
+    fp.writel(min(baseOffset, 0xffffffff), 4);     //offset of central directory
     fp.writel(0x0000, 2);                     //comment length
 
     fp.close();
@@ -90,9 +130,9 @@ protected:
   struct entry_t {
     string filename;
     uint32_t checksum;
-    uint32_t compressedSize;
-    uint32_t uncompressedSize;
-    uint32_t offset;
+    uint64_t compressedSize;
+    uint64_t uncompressedSize;
+    uint64_t offset;
   };
   vector<entry_t> directory;
 };
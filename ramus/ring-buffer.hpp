@@ -0,0 +1,135 @@
+#pragma once
+
+//bounded single-producer, single-consumer ring buffer for connecting pipeline stages
+//push() blocks while full and pop() blocks while empty; tryPush() and tryPop() never wait on the
+//other side, for one (such as a user interface thread) that must not
+//a side that has to wait sleeps on a condition variable, which the other side only signals while
+//someone is waiting, so that handing items over costs no locking while neither side waits
+//close() may be called from either side: it ends the stream for the consumer once drained,
+//and makes further pushes fail so that a producer whose consumer gave up can stop early
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <nall/vector.hpp>
+
+namespace ramus {
+
+using namespace nall;
+
+template<typename T> struct RingBuffer {
+  RingBuffer(uint capacity = 4096) {
+    uint size = 1;
+    while(size < capacity) size <<= 1;
+    pool.resize(size);
+    mask = size - 1;
+  }
+
+  auto push(T value) -> bool {
+    uint offset = writeOffset.load(std::memory_order_relaxed);
+    wait([&] { return closed || offset - readOffset.load(std::memory_order_acquire) <= mask; });
+    if(closed) return false;
+    pool[offset & mask] = move(value);
+    writeOffset.store(offset + 1, std::memory_order_release);
+    notify();
+    return true;
+  }
+
+  //returns false if full or closed
+  auto tryPush(T value) -> bool {
+    uint offset = writeOffset.load(std::memory_order_relaxed);
+    if(offset - readOffset.load(std::memory_order_acquire) > mask || closed) return false;
+    pool[offset & mask] = move(value);
+    writeOffset.store(offset + 1, std::memory_order_release);
+    notify();
+    return true;
+  }
+
+  auto push(const T* data, uint count) -> bool {
+    while(count) {
+      uint offset = writeOffset.load(std::memory_order_relaxed);
+      uint space = 0;
+      wait([&] { return closed || (space = mask + 1 - (offset - readOffset.load(std::memory_order_acquire))); });
+      if(closed) return false;
+      uint length = min(count, space);
+      for(uint n : range(length)) pool[(offset + n) & mask] = data[n];
+      writeOffset.store(offset + length, std::memory_order_release);
+      notify();
+      data += length;
+      count -= length;
+    }
+    return true;
+  }
+
+  //returns false once the stream is closed and drained
+  auto pop(T& value) -> bool {
+    uint offset = readOffset.load(std::memory_order_relaxed);
+    wait([&] { return closed || writeOffset.load(std::memory_order_acquire) != offset; });
+    if(writeOffset.load(std::memory_order_acquire) == offset) return false;  //closed and drained
+    value = move(pool[offset & mask]);
+    readOffset.store(offset + 1, std::memory_order_release);
+    notify();
+    return true;
+  }
+
+  //returns false if empty
+  auto tryPop(T& value) -> bool {
+    uint offset = readOffset.load(std::memory_order_relaxed);
+    if(writeOffset.load(std::memory_order_acquire) == offset) return false;
+    value = move(pool[offset & mask]);
+    readOffset.store(offset + 1, std::memory_order_release);
+    notify();
+    return true;
+  }
+
+  //returns the number of items read; fewer than count only at the end of the stream
+  auto pop(T* data, uint count) -> uint {
+    uint total = 0;
+    while(total < count) {
+      uint offset = readOffset.load(std::memory_order_relaxed);
+      uint available = 0;
+      wait([&] { return (available = writeOffset.load(std::memory_order_acquire) - offset) || closed; });
+      if(!available && !(available = writeOffset.load(std::memory_order_acquire) - offset)) return total;  //closed and drained
+      uint length = min(count - total, available);
+      for(uint n : range(length)) data[total + n] = pool[(offset + n) & mask];
+      readOffset.store(offset + length, std::memory_order_release);
+      notify();
+      total += length;
+    }
+    return total;
+  }
+
+  auto close() -> void {
+    closed = true;
+    notify();
+  }
+
+private:
+  template<typename F> auto wait(const F& ready) -> void {
+    if(ready()) return;
+    std::unique_lock<std::mutex> lock(mutex);
+    waiters.fetch_add(1);
+    //pairs with the fence in notify(): either the other side sees this waiter, or ready() sees its update
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    condition.wait(lock, ready);
+    waiters.fetch_sub(1);
+  }
+
+  auto notify() -> void {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(!waiters.load(std::memory_order_relaxed)) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    condition.notify_all();
+  }
+
+  vector<T> pool;
+  uint mask;
+  std::atomic<uint> readOffset{0};
+  std::atomic<uint> writeOffset{0};
+  std::atomic<bool> closed{false};
+  std::atomic<uint> waiters{0};
+  std::mutex mutex;
+  std::condition_variable condition;
+};
+
+}